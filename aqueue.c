@@ -0,0 +1,350 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "aqueue.h"
+#include "queue.h"
+
+#define aq_entry(h) container_of(h, aqueue_t, head)
+
+/* Number of slots of a new arena, the sentinel included */
+#define AQ_INIT_CAPACITY 16
+
+/* Create an empty queue */
+struct list_head *aq_new()
+{
+    aqueue_t *q = malloc(sizeof(aqueue_t));
+    if (!q)
+        return NULL;
+
+    q->nodes = malloc(AQ_INIT_CAPACITY * sizeof(aq_node_t));
+    if (!q->nodes) {
+        free(q);
+        return NULL;
+    }
+    q->nodes[AQ_NIL].prev = q->nodes[AQ_NIL].next = AQ_NIL;
+    q->nodes[AQ_NIL].value = NULL;
+    q->capacity = AQ_INIT_CAPACITY;
+    q->used = 1;
+    q->free = AQ_NIL;
+    q->size = 0;
+
+    INIT_LIST_HEAD(&q->head);
+    return &q->head;
+}
+
+/* Free all storage used by queue */
+void aq_free(struct list_head *head)
+{
+    if (!head)
+        return;
+
+    aqueue_t *q = aq_entry(head);
+    for (uint32_t i = q->nodes[AQ_NIL].next; i != AQ_NIL;
+         i = q->nodes[i].next)
+        free(q->nodes[i].value);
+    free(q->nodes);
+    free(q);
+}
+
+/* Make room for @extra more slots, moving the arena if needed */
+static bool aq_reserve(aqueue_t *q, size_t extra)
+{
+    if (extra <= q->capacity - q->used)
+        return true;
+    if (extra > UINT32_MAX - q->used)
+        return false;
+
+    size_t capacity = q->capacity;
+    while (capacity < q->used + extra)
+        capacity *= 2;
+    if (capacity > UINT32_MAX)
+        capacity = UINT32_MAX;
+
+    /* No realloc in the harness, the slots are copied over */
+    aq_node_t *nodes = malloc(capacity * sizeof(aq_node_t));
+    if (!nodes)
+        return false;
+    memcpy(nodes, q->nodes, q->used * sizeof(aq_node_t));
+    free(q->nodes);
+    q->nodes = nodes;
+    q->capacity = capacity;
+    return true;
+}
+
+/* Take a slot for @value, reusing released slots first */
+static uint32_t aq_alloc(aqueue_t *q, char *value)
+{
+    uint32_t i = q->free;
+    if (i != AQ_NIL) {
+        q->free = q->nodes[i].prev;
+    } else {
+        if (!aq_reserve(q, 1))
+            return AQ_NIL;
+        i = q->used++;
+    }
+    q->nodes[i].value = value;
+    return i;
+}
+
+/* Link slot @i between @prev and @next */
+static inline void aq_link(aq_node_t *nodes,
+                           uint32_t i,
+                           uint32_t prev,
+                           uint32_t next)
+{
+    nodes[i].prev = prev;
+    nodes[i].next = next;
+    nodes[prev].next = i;
+    nodes[next].prev = i;
+}
+
+/* Insert a copy of @s at the head or the tail of queue */
+static bool aq_insert(aqueue_t *q, const char *s, bool tail)
+{
+    char *value = strdup(s);
+    if (!value)
+        return false;
+
+    uint32_t i = aq_alloc(q, value);
+    if (i == AQ_NIL) {
+        free(value);
+        return false;
+    }
+
+    /* The arena may have moved, read the neighbours afterwards */
+    uint32_t prev = tail ? q->nodes[AQ_NIL].prev : AQ_NIL;
+    aq_link(q->nodes, i, prev, q->nodes[prev].next);
+    q->size++;
+    return true;
+}
+
+/* Insert an element at head of queue */
+bool aq_insert_head(struct list_head *head, const char *s)
+{
+    if (!head || !s)
+        return false;
+    return aq_insert(aq_entry(head), s, false);
+}
+
+/* Insert an element at tail of queue */
+bool aq_insert_tail(struct list_head *head, const char *s)
+{
+    if (!head || !s)
+        return false;
+    return aq_insert(aq_entry(head), s, true);
+}
+
+/* Unlink slot @i, copy its string to @sp and release both */
+static void aq_remove(aqueue_t *q, uint32_t i, char *sp, size_t bufsize)
+{
+    aq_node_t *node = &q->nodes[i];
+    q->nodes[node->prev].next = node->next;
+    q->nodes[node->next].prev = node->prev;
+
+    if (sp && bufsize > 0) {
+        strncpy(sp, node->value, bufsize - 1);
+        sp[bufsize - 1] = '\0';
+    }
+    free(node->value);
+    node->prev = q->free;
+    q->free = i;
+    q->size--;
+}
+
+/* Remove an element from head of queue */
+bool aq_remove_head(struct list_head *head, char *sp, size_t bufsize)
+{
+    if (!head || !aq_entry(head)->size)
+        return false;
+
+    aqueue_t *q = aq_entry(head);
+    aq_remove(q, q->nodes[AQ_NIL].next, sp, bufsize);
+    return true;
+}
+
+/* Remove an element from tail of queue */
+bool aq_remove_tail(struct list_head *head, char *sp, size_t bufsize)
+{
+    if (!head || !aq_entry(head)->size)
+        return false;
+
+    aqueue_t *q = aq_entry(head);
+    aq_remove(q, q->nodes[AQ_NIL].prev, sp, bufsize);
+    return true;
+}
+
+/* Return number of elements in queue */
+size_t aq_size(struct list_head *head)
+{
+    return head ? aq_entry(head)->size : 0;
+}
+
+/* Reverse elements in queue by swapping the links of every node */
+void aq_reverse(struct list_head *head)
+{
+    if (!head)
+        return;
+
+    aq_node_t *nodes = aq_entry(head)->nodes;
+    uint32_t i = AQ_NIL;
+    do {
+        uint32_t next = nodes[i].next;
+        nodes[i].next = nodes[i].prev;
+        nodes[i].prev = next;
+        i = next;
+    } while (i != AQ_NIL);
+}
+
+static inline int aq_cmp(const aq_node_t *nodes,
+                         uint32_t a,
+                         uint32_t b,
+                         bool descend)
+{
+    int cmp = strcmp(nodes[a].value, nodes[b].value);
+    return descend ? -cmp : cmp;
+}
+
+/* Merge two sorted chains ended by AQ_NIL, @a holding the earlier nodes */
+static uint32_t aq_merge(aq_node_t *nodes, uint32_t a, uint32_t b, bool descend)
+{
+    uint32_t head = AQ_NIL, *tail = &head;
+    for (;;) {
+        if (aq_cmp(nodes, a, b, descend) <= 0) {
+            *tail = a;
+            tail = &nodes[a].next;
+            a = nodes[a].next;
+            if (a == AQ_NIL) {
+                *tail = b;
+                break;
+            }
+        } else {
+            *tail = b;
+            tail = &nodes[b].next;
+            b = nodes[b].next;
+            if (b == AQ_NIL) {
+                *tail = a;
+                break;
+            }
+        }
+    }
+    return head;
+}
+
+/* Sort elements of queue in ascending/descending order */
+void aq_sort(struct list_head *head, bool descend)
+{
+    if (!head || aq_entry(head)->size < 2)
+        return;
+
+    aq_node_t *nodes = aq_entry(head)->nodes;
+    uint32_t list = nodes[AQ_NIL].next, pending = AQ_NIL;
+    size_t count = 0;
+
+    /* Pending sublists are chained through prev, see LIST_SORT_DEFINE() */
+    nodes[nodes[AQ_NIL].prev].next = AQ_NIL;
+    do {
+        size_t bits;
+        uint32_t *tail = &pending;
+        for (bits = count; bits & 1; bits >>= 1)
+            tail = &nodes[*tail].prev;
+        if (bits) {
+            uint32_t a = *tail, b = nodes[a].prev;
+            a = aq_merge(nodes, b, a, descend);
+            nodes[a].prev = nodes[b].prev;
+            *tail = a;
+        }
+        nodes[list].prev = pending;
+        pending = list;
+        list = nodes[list].next;
+        nodes[pending].next = AQ_NIL;
+        count++;
+    } while (list != AQ_NIL);
+
+    list = pending;
+    pending = nodes[pending].prev;
+    while (pending != AQ_NIL) {
+        uint32_t next = nodes[pending].prev;
+        list = aq_merge(nodes, pending, list, descend);
+        pending = next;
+    }
+
+    /* Rebuild the prev links and close the circle */
+    uint32_t prev = AQ_NIL;
+    nodes[AQ_NIL].next = list;
+    for (uint32_t i = list; i != AQ_NIL; prev = i, i = nodes[i].next)
+        nodes[i].prev = prev;
+    nodes[prev].next = AQ_NIL;
+    nodes[AQ_NIL].prev = prev;
+}
+
+/* Get the first elements of the queue */
+size_t aq_peek(struct list_head *head, const char **out, size_t n)
+{
+    if (!head)
+        return 0;
+
+    const aq_node_t *nodes = aq_entry(head)->nodes;
+    size_t got = 0;
+    for (uint32_t i = nodes[AQ_NIL].next; got < n && i != AQ_NIL;
+         i = nodes[i].next)
+        out[got++] = nodes[i].value;
+    return got;
+}
+
+/* Move all elements of a queue of element_t to the tail of the queue */
+bool aq_from_list(struct list_head *head, struct list_head *list)
+{
+    if (!head || !list)
+        return false;
+
+    aqueue_t *q = aq_entry(head);
+    size_t n = q_size(list);
+    if (!aq_reserve(q, n))
+        return false;
+
+    element_t *entry, *safe;
+    list_for_each_entry_safe(entry, safe, list, list) {
+        uint32_t i = aq_alloc(q, entry->value);
+        aq_link(q->nodes, i, q->nodes[AQ_NIL].prev, AQ_NIL);
+        q->size++;
+        free(entry);
+    }
+    INIT_LIST_HEAD(list);
+    return true;
+}
+
+/* Move all elements to the tail of a queue of element_t */
+bool aq_to_list(struct list_head *head, struct list_head *list)
+{
+    if (!head || !list)
+        return false;
+
+    /* Allocate every element first, so that a failure moves nothing */
+    aqueue_t *q = aq_entry(head);
+    LIST_HEAD(entries);
+    for (size_t n = 0; n < q->size; n++) {
+        element_t *entry = malloc(sizeof(element_t));
+        if (!entry) {
+            element_t *safe;
+            list_for_each_entry_safe(entry, safe, &entries, list)
+                free(entry);
+            return false;
+        }
+        list_add_tail(&entry->list, &entries);
+    }
+
+    element_t *entry, *safe;
+    list_for_each_entry_safe(entry, safe, &entries, list) {
+        uint32_t i = q->nodes[AQ_NIL].next;
+        entry->value = q->nodes[i].value;
+        list_move_tail(&entry->list, list);
+        /* The string now belongs to the element, release the slot only */
+        q->nodes[AQ_NIL].next = q->nodes[i].next;
+        q->nodes[q->nodes[i].next].prev = AQ_NIL;
+        q->nodes[i].prev = q->free;
+        q->free = i;
+        q->size--;
+    }
+    return true;
+}
@@ -0,0 +1,166 @@
+#ifndef LAB0_AQUEUE_H
+#define LAB0_AQUEUE_H
+
+/* This program implements a queue of strings whose nodes live in an arena.
+ *
+ * All nodes of a queue are slots of one array and link to each other by
+ * 32-bit indices instead of pointers, so a node takes 16 bytes including the
+ * pointer to its string, against 24 bytes for an element_t plus the overhead
+ * of allocating it on its own. The array may move when it grows, which does
+ * not affect the links.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "harness.h"
+#include "list.h"
+
+/* Index of the sentinel slot, which also ends chains of slots */
+#define AQ_NIL 0
+
+/**
+ * aq_node_t - Slot of the arena
+ * @prev: index of the previous node, the next free slot for a free slot
+ * @next: index of the next node
+ * @value: pointer to array holding string
+ *
+ * Slot AQ_NIL is the sentinel of the circular list, like the head of a
+ * list_head list.
+ */
+typedef struct {
+    uint32_t prev, next;
+    char *value;
+} aq_node_t;
+
+/**
+ * aqueue_t - Arena-backed queue
+ * @head: list head used as the handle of the queue, so that it can be kept
+ *        wherever a queue head is expected. It is never linked and always
+ *        looks like an empty list.
+ * @nodes: the arena
+ * @capacity: number of slots in @nodes
+ * @used: number of slots ever handed out, including the sentinel
+ * @free: index of the first released slot, AQ_NIL if there is none
+ * @size: number of elements
+ */
+typedef struct {
+    struct list_head head;
+    aq_node_t *nodes;
+    uint32_t capacity, used, free, size;
+} aqueue_t;
+
+/* Operations on arena-backed queue */
+
+/**
+ * aq_new() - Create an empty arena-backed queue
+ *
+ * Return: the handle of the queue, NULL for allocation failed
+ */
+struct list_head *aq_new();
+
+/**
+ * aq_free() - Free all storage used by the queue, no effect if @head is NULL
+ * @head: handle of the queue
+ */
+void aq_free(struct list_head *head);
+
+/**
+ * aq_insert_head() - Insert an element at the head
+ * @head: handle of the queue
+ * @s: string would be inserted
+ *
+ * Return: true for success, false for allocation failed or @head is NULL
+ */
+bool aq_insert_head(struct list_head *head, const char *s);
+
+/**
+ * aq_insert_tail() - Insert an element at the tail
+ * @head: handle of the queue
+ * @s: string would be inserted
+ *
+ * Return: true for success, false for allocation failed or @head is NULL
+ */
+bool aq_insert_tail(struct list_head *head, const char *s);
+
+/**
+ * aq_remove_head() - Remove and release the element from head of the queue
+ * @head: handle of the queue
+ * @sp: output buffer where the removed string is copied
+ * @bufsize: size of the string
+ *
+ * The slot is kept for later insertions.
+ *
+ * Return: true for success, false if queue is NULL or empty.
+ */
+bool aq_remove_head(struct list_head *head, char *sp, size_t bufsize);
+
+/**
+ * aq_remove_tail() - Remove and release the element from tail of the queue
+ * @head: handle of the queue
+ * @sp: output buffer where the removed string is copied
+ * @bufsize: size of the string
+ *
+ * Return: true for success, false if queue is NULL or empty.
+ */
+bool aq_remove_tail(struct list_head *head, char *sp, size_t bufsize);
+
+/**
+ * aq_size() - Get the number of elements in the queue
+ * @head: handle of the queue
+ *
+ * Return: the number of elements, zero if queue is NULL or empty
+ */
+size_t aq_size(struct list_head *head);
+
+/**
+ * aq_reverse() - Reverse elements in the queue
+ * @head: handle of the queue
+ */
+void aq_reverse(struct list_head *head);
+
+/**
+ * aq_sort() - Sort elements of the queue in ascending/descending order
+ * @head: handle of the queue
+ * @descend: whether or not to sort in descending order
+ *
+ * Same stable bottom-up merge sort as list_sort(), on indices.
+ */
+void aq_sort(struct list_head *head, bool descend);
+
+/**
+ * aq_peek() - Get the first elements of the queue
+ * @head: handle of the queue
+ * @out: array receiving pointers to the strings, from the head onward
+ * @n: capacity of @out
+ *
+ * Return: the number of strings stored in @out
+ */
+size_t aq_peek(struct list_head *head, const char **out, size_t n);
+
+/**
+ * aq_from_list() - Move all elements of a queue of element_t to the tail
+ * @head: handle of the arena-backed queue
+ * @list: header of a queue of element_t, left empty
+ *
+ * The strings are handed over, only the element_t are released.
+ *
+ * Return: true for success, false for allocation failed, in which case
+ * nothing is moved
+ */
+bool aq_from_list(struct list_head *head, struct list_head *list);
+
+/**
+ * aq_to_list() - Move all elements to the tail of a queue of element_t
+ * @head: handle of the arena-backed queue
+ * @list: header of a queue of element_t
+ *
+ * The strings are handed over and the arena keeps its slots.
+ *
+ * Return: true for success, false for allocation failed, in which case
+ * nothing is moved
+ */
+bool aq_to_list(struct list_head *head, struct list_head *list);
+
+#endif /* LAB0_AQUEUE_H */
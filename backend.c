@@ -0,0 +1,207 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "backend.h"
+#include "aqueue.h"
+#include "cqueue.h"
+#include "fqueue.h"
+#include "queue.h"
+#include "squeue.h"
+#include "vqueue.h"
+#include "xqueue.h"
+
+/* The doubly-linked list of queue.c works on elements, adapt it to strings */
+
+static bool dl_insert_head(struct list_head *head, const char *s)
+{
+    return q_insert_head(head, (char *) s);
+}
+
+static bool dl_insert_tail(struct list_head *head, const char *s)
+{
+    return q_insert_tail(head, (char *) s);
+}
+
+static bool dl_remove_head(struct list_head *head, char *sp, size_t bufsize)
+{
+    element_t *e = q_remove_head(head, sp, bufsize);
+    if (e)
+        q_release_element(e);
+    return e;
+}
+
+static bool dl_remove_tail(struct list_head *head, char *sp, size_t bufsize)
+{
+    element_t *e = q_remove_tail(head, sp, bufsize);
+    if (e)
+        q_release_element(e);
+    return e;
+}
+
+static size_t dl_size(struct list_head *head)
+{
+    return q_size(head);
+}
+
+static bool dl_sort(struct list_head *head, bool descend)
+{
+    q_sort(head, descend);
+    return true;
+}
+
+static size_t dl_peek(struct list_head *head, const char **out, size_t n)
+{
+    if (!head)
+        return 0;
+
+    size_t got = 0;
+    const element_t *e;
+    list_for_each_entry(e, head, list) {
+        if (got == n)
+            break;
+        out[got++] = e->value;
+    }
+    return got;
+}
+
+static bool arena_sort(struct list_head *head, bool descend)
+{
+    aq_sort(head, descend);
+    return true;
+}
+
+static const queue_backend_t list_backend = {
+    .name = "list",
+    .summary = "Doubly-linked list of queue.c",
+    .new = q_new,
+    .release = q_free,
+    .insert_head = dl_insert_head,
+    .insert_tail = dl_insert_tail,
+    .remove_head = dl_remove_head,
+    .remove_tail = dl_remove_tail,
+    .size = dl_size,
+    .reverse = q_reverse,
+    .sort = dl_sort,
+    .delete_dup = q_delete_dup,
+    .peek = dl_peek,
+};
+
+static const queue_backend_t slist_backend = {
+    .name = "slist",
+    .summary = "Singly-linked tail queue",
+    .new = sq_new,
+    .release = sq_free,
+    .insert_head = sq_insert_head,
+    .insert_tail = sq_insert_tail,
+    .remove_head = sq_remove_head,
+    .size = sq_size,
+    .reverse = sq_reverse,
+    .peek = sq_peek,
+};
+
+static const queue_backend_t xor_backend = {
+    .name = "xor",
+    .summary = "XOR-linked list",
+    .new = xq_new,
+    .release = xq_free,
+    .insert_head = xq_insert_head,
+    .insert_tail = xq_insert_tail,
+    .remove_head = xq_remove_head,
+    .remove_tail = xq_remove_tail,
+    .size = xq_size,
+    .reverse = xq_reverse,
+    .peek = xq_peek,
+};
+
+static const queue_backend_t arena_backend = {
+    .name = "arena",
+    .summary = "Nodes in one array, linked by 32-bit indices",
+    .new = aq_new,
+    .release = aq_free,
+    .insert_head = aq_insert_head,
+    .insert_tail = aq_insert_tail,
+    .remove_head = aq_remove_head,
+    .remove_tail = aq_remove_tail,
+    .size = aq_size,
+    .reverse = aq_reverse,
+    .sort = arena_sort,
+    .peek = aq_peek,
+};
+
+static const queue_backend_t array_backend = {
+    .name = "array",
+    .summary = "Ring buffer of strings",
+    .new = vq_new,
+    .release = vq_free,
+    .insert_head = vq_insert_head,
+    .insert_tail = vq_insert_tail,
+    .remove_head = vq_remove_head,
+    .remove_tail = vq_remove_tail,
+    .size = vq_size,
+    .reverse = vq_reverse,
+    .sort = vq_sort,
+    .delete_dup = vq_delete_dup,
+    .peek = vq_peek,
+};
+
+static const queue_backend_t chunk_backend = {
+    .name = "chunk",
+    .summary = "Linked chunks of strings",
+    .new = cq_new,
+    .release = cq_free,
+    .insert_head = cq_insert_head,
+    .insert_tail = cq_insert_tail,
+    .remove_head = cq_remove_head,
+    .remove_tail = cq_remove_tail,
+    .size = cq_size,
+    .reverse = cq_reverse,
+    .sort = cq_sort,
+    .delete_dup = cq_delete_dup,
+    .peek = cq_peek,
+};
+
+static const queue_backend_t mmap_backend = {
+    .name = "mmap",
+    .summary = "Nodes in a memory-mapped file, linked by offsets",
+    .new = fq_new,
+    .release = fq_free,
+    .insert_head = fq_insert_head,
+    .insert_tail = fq_insert_tail,
+    .remove_head = fq_remove_head,
+    .remove_tail = fq_remove_tail,
+    .size = fq_size,
+    .reverse = fq_reverse,
+    .peek = fq_peek,
+    .open = fq_open,
+    .sync = fq_sync,
+};
+
+const queue_backend_t *const queue_backends[] = {
+    &list_backend,  &slist_backend, &xor_backend,   &arena_backend,
+    &array_backend, &chunk_backend, &mmap_backend,
+};
+
+#define ARRAY_SIZE(a) (sizeof(a) / sizeof((a)[0]))
+
+const int queue_backend_count = ARRAY_SIZE(queue_backends);
+
+const queue_backend_t *queue_backend = &list_backend;
+
+const char *const *backend_names()
+{
+    static const char *names[ARRAY_SIZE(queue_backends) + 1];
+
+    for (int i = 0; i < queue_backend_count; i++)
+        names[i] = queue_backends[i]->name;
+    return names;
+}
+
+int backend_find(const char *name)
+{
+    for (int i = 0; i < queue_backend_count; i++) {
+        if (!strcmp(queue_backends[i]->name, name))
+            return i;
+    }
+    return -1;
+}
@@ -0,0 +1,78 @@
+#ifndef LAB0_BACKEND_H
+#define LAB0_BACKEND_H
+
+/* This program lets the same queue commands drive several implementations.
+ *
+ * Every implementation of a queue of strings is described by a table of
+ * function pointers covering the queue API, so that callers pick one at run
+ * time and the same trace can be replayed against each of them.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "list.h"
+
+/**
+ * queue_backend_t - Implementation of a queue of strings
+ * @name: name used to select the implementation
+ * @summary: one line description
+ * @new: create an empty queue and return its handle, NULL on failure
+ * @release: free all storage used by a queue, no effect on NULL
+ * @insert_head: insert a copy of the string at the head
+ * @insert_tail: insert a copy of the string at the tail
+ * @remove_head: remove the head, copying its string to the buffer if any
+ * @remove_tail: remove the tail, copying its string to the buffer if any
+ * @size: number of elements
+ * @reverse: reverse the elements
+ * @sort: sort the elements, false for allocation failed
+ * @delete_dup: delete the strings of a sorted queue appearing more than once
+ * @peek: store pointers to the first strings, return how many were stored
+ * @open: open a queue stored in the named file, NULL on failure
+ * @sync: make the queue durable in its file, false on failure
+ *
+ * Operations an implementation does not provide are NULL.
+ */
+typedef struct {
+    const char *name;
+    const char *summary;
+    struct list_head *(*new)();
+    void (*release)(struct list_head *head);
+    bool (*insert_head)(struct list_head *head, const char *s);
+    bool (*insert_tail)(struct list_head *head, const char *s);
+    bool (*remove_head)(struct list_head *head, char *sp, size_t bufsize);
+    bool (*remove_tail)(struct list_head *head, char *sp, size_t bufsize);
+    size_t (*size)(struct list_head *head);
+    void (*reverse)(struct list_head *head);
+    bool (*sort)(struct list_head *head, bool descend);
+    bool (*delete_dup)(struct list_head *head);
+    size_t (*peek)(struct list_head *head, const char **out, size_t n);
+    struct list_head *(*open)(const char *path);
+    bool (*sync)(struct list_head *head);
+} queue_backend_t;
+
+/* Available implementations, the linked list of queue.c first */
+extern const queue_backend_t *const queue_backends[];
+
+/* Number of entries in queue_backends */
+extern const int queue_backend_count;
+
+/* Implementation used for queues created from now on */
+extern const queue_backend_t *queue_backend;
+
+/**
+ * backend_names() - Names of the implementations
+ *
+ * Return: the names in the order of queue_backends, NULL-terminated
+ */
+const char *const *backend_names();
+
+/**
+ * backend_find() - Look up an implementation by name
+ * @name: name of the implementation
+ *
+ * Return: the index in queue_backends, -1 if there is no such implementation
+ */
+int backend_find(const char *name);
+
+#endif /* LAB0_BACKEND_H */
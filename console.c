@@ -4,6 +4,7 @@
 #include <fcntl.h>
 #include <limits.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -29,17 +30,79 @@ static bool block_timing = false;
 /* Time of day */
 static double first_time, last_time;
 
+/* Commands by name, hashed with open addressing, to find them in O(1) */
+#define CMD_TABLE_SIZE 256
+static cmd_element_t *cmd_table[CMD_TABLE_SIZE];
+static int cmd_cnt = 0;
+
 /* Implement buffered I/O using variant of RIO package from CS:APP
  * Must create stack of buffers to handle I/O with nested source commands.
  */
 
 #define RIO_BUFSIZE 8192
 
+/* Command files are compiled a block of lines at a time: each line is split
+ * into its arguments and its command looked up once, then the block runs
+ * from memory. With caching on, the blocks are also saved next to the file,
+ * and later runs read them back instead of parsing it again.
+ */
+#define PROG_SRC 16384  /* Source bytes buffered */
+#define PROG_INSN 1024  /* Lines per block */
+#define PROG_ARGS 4096  /* Arguments per block */
+#define PROG_TEXT 32768 /* Bytes of lines and arguments per block */
+
+#define CACHE_SUFFIX ".bc"
+#define CACHE_MAGIC "lab0-bc1"
+
+/* A compiled line */
+typedef struct {
+    cmd_element_t *cmd; /* NULL if unknown or for an empty line */
+    int argc;
+    char **argv;
+    char *line; /* Text of the line to echo, ending with a newline */
+} insn_t;
+
+/* Identifies the source a cache was compiled from */
+typedef struct {
+    char magic[8];
+    int64_t size, sec, nsec;
+} cache_header_t;
+
+/* A block is stored in the cache as this header, the argument count of each
+ * line, then the text: each line followed by its arguments, all
+ * null-terminated. A header with no lines, ending at the size of the source,
+ * marks the end of a complete cache.
+ */
+typedef struct {
+    uint32_t n, len; /* Lines and bytes of text */
+    int64_t src_end; /* Offset in the source past the lines of the block */
+} block_header_t;
+
+typedef struct {
+    int n, pc;        /* Lines in block and next one to run */
+    size_t len;       /* Bytes of text used */
+    size_t argv_cnt;  /* Arguments used */
+    size_t pos, end;  /* Unread part of src */
+    bool eof;         /* Whole source read */
+    int64_t src_off;  /* Source bytes compiled or covered by the cache */
+    int64_t src_size; /* Size of the source when opened */
+    FILE *cache;      /* Cache read, or written when tmp_name is set */
+    char *cache_name; /* Name of the cache */
+    char *tmp_name;   /* Name of the cache while it is written */
+    insn_t insn[PROG_INSN];
+    char *argv[PROG_ARGS];
+    char text[PROG_TEXT];
+    char src[PROG_SRC];
+} prog_t;
+
 typedef struct __rio {
     int fd;                /* File descriptor */
     int count;             /* Unread bytes in internal buffer */
     char *bufptr;          /* Next unread byte in internal buffer */
     char buf[RIO_BUFSIZE]; /* Internal buffer */
+    prog_t *prog;          /* Compiled commands, NULL to read lines */
+    int busy;              /* Commands of prog running */
+    bool dropped;          /* Popped while busy, freed once done */
     struct __rio *prev;    /* Next element in stack */
 } rio_t;
 
@@ -53,6 +116,7 @@ static int fd_max = 0;
 static int err_limit = 5;
 static int err_cnt = 0;
 static int echo = 0;
+static bool cmd_cache = false;
 
 static bool quit_flag = false;
 static char *prompt = "cmd> ";
@@ -72,6 +136,32 @@ static void pop_file();
 
 static bool interpret_cmda(int argc, char *argv[]);
 
+/* FNV-1a hash of a command name */
+static unsigned cmd_hash(const char *name)
+{
+    uint32_t hash = 2166136261u;
+    while (*name)
+        hash = (hash ^ (unsigned char) *name++) * 16777619u;
+    return hash;
+}
+
+/* Slot of a command in cmd_table, empty if it is not there */
+static cmd_element_t **cmd_slot(const char *name)
+{
+    unsigned i = cmd_hash(name);
+    cmd_element_t **slot;
+    while (*(slot = &cmd_table[i++ % CMD_TABLE_SIZE]) &&
+           strcmp(name, (*slot)->name))
+        ;
+    return slot;
+}
+
+static void clear_cmd_table()
+{
+    memset(cmd_table, 0, sizeof(cmd_table));
+    cmd_cnt = 0;
+}
+
 /* Add a new command */
 void add_cmd(char *name, cmd_func_t operation, char *summary, char *param)
 {
@@ -89,10 +179,28 @@ void add_cmd(char *name, cmd_func_t operation, char *summary, char *param)
     cmd->param = param;
     cmd->next = next_cmd;
     *last_loc = cmd;
+
+    /* Keep a slot free to end lookups, a later command replaces an earlier
+     * one of the same name as in cmd_list
+     */
+    cmd_element_t **slot = cmd_slot(name);
+    if (!*slot && ++cmd_cnt == CMD_TABLE_SIZE)
+        report_event(MSG_FATAL, "Exceeded limit on commands");
+    *slot = cmd;
 }
 
 /* Add a new parameter */
 void add_param(char *name, int *valp, char *summary, setter_func_t setter)
+{
+    add_enum_param(name, valp, NULL, summary, setter);
+}
+
+/* Add a new parameter whose value is the index of one of the given names */
+void add_enum_param(char *name,
+                    int *valp,
+                    const char *const *names,
+                    char *summary,
+                    setter_func_t setter)
 {
     param_element_t *next_param = param_list;
     param_element_t **last_loc = &param_list;
@@ -105,6 +213,7 @@ void add_param(char *name, int *valp, char *summary, setter_func_t setter)
         malloc_or_fail(sizeof(param_element_t), "add_param");
     param->name = name;
     param->valp = valp;
+    param->names = names;
     param->summary = summary;
     param->setter = setter;
     param->next = next_param;
@@ -169,16 +278,14 @@ static void record_error()
     }
 }
 
-/* Execute a command that has already been split into arguments */
-static bool interpret_cmda(int argc, char *argv[])
+/* Execute a command already looked up, NULL if there is none by the name of
+ * argv[0]
+ */
+static bool run_cmd(cmd_element_t *next_cmd, int argc, char *argv[])
 {
     if (argc == 0)
         return true;
-    /* Try to find matching command */
-    cmd_element_t *next_cmd = cmd_list;
     bool ok = true;
-    while (next_cmd && strcmp(argv[0], next_cmd->name) != 0)
-        next_cmd = next_cmd->next;
     if (next_cmd) {
         ok = next_cmd->operation(argc, argv);
         if (!ok)
@@ -192,6 +299,12 @@ static bool interpret_cmda(int argc, char *argv[])
     return ok;
 }
 
+/* Execute a command that has already been split into arguments */
+static bool interpret_cmda(int argc, char *argv[])
+{
+    return run_cmd(argc ? *cmd_slot(argv[0]) : NULL, argc, argv);
+}
+
 /* Execute a command from a command line */
 static bool interpret_cmd(char *cmdline)
 {
@@ -223,6 +336,12 @@ void set_echo(bool on)
     echo = on ? 1 : 0;
 }
 
+/* Turn caching of compiled command files on/off */
+void set_cmd_cache(bool on)
+{
+    cmd_cache = on;
+}
+
 /* Built-in commands */
 static bool do_quit(int argc, char *argv[])
 {
@@ -233,6 +352,7 @@ static bool do_quit(int argc, char *argv[])
         c = c->next;
         free_block(ele, sizeof(cmd_element_t));
     }
+    clear_cmd_table();
 
     param_element_t *p = param_list;
     while (p) {
@@ -252,6 +372,43 @@ static bool do_quit(int argc, char *argv[])
     return ok;
 }
 
+/* Show a parameter with its value, by name for enumerated parameters */
+static void report_param(const param_element_t *plist)
+{
+    if (plist->names)
+        report(1, "  %-12s%-12s | %s", plist->name,
+               plist->names[*plist->valp], plist->summary);
+    else
+        report(1, "  %-12s%-12d | %s", plist->name, *plist->valp,
+               plist->summary);
+}
+
+/* Extract value of parameter from text, by name for enumerated parameters */
+static bool get_param_value(const param_element_t *plist,
+                            char *vname,
+                            int *loc)
+{
+    if (!plist->names) {
+        if (get_int(vname, loc))
+            return true;
+        report(1, "Cannot parse '%s' as integer", vname);
+        return false;
+    }
+
+    for (int i = 0; plist->names[i]; i++) {
+        if (!strcmp(plist->names[i], vname)) {
+            *loc = i;
+            return true;
+        }
+    }
+    report_noreturn(1, "Unknown value '%s' for parameter %s, expected", vname,
+                    plist->name);
+    for (int i = 0; plist->names[i]; i++)
+        report_noreturn(1, " %s", plist->names[i]);
+    report(1, "");
+    return false;
+}
+
 static bool do_help(int argc, char *argv[])
 {
     cmd_element_t *clist = cmd_list;
@@ -264,8 +421,7 @@ static bool do_help(int argc, char *argv[])
     param_element_t *plist = param_list;
     report(1, "Options:");
     while (plist) {
-        report(1, "  %-12s%-12d | %s", plist->name, *plist->valp,
-               plist->summary);
+        report_param(plist);
         plist = plist->next;
     }
     return true;
@@ -303,8 +459,7 @@ static bool do_option(int argc, char *argv[])
         param_element_t *plist = param_list;
         report(1, "Options:");
         while (plist) {
-            report(1, "  %-12s%-12d | %s", plist->name, *plist->valp,
-                   plist->summary);
+            report_param(plist);
             plist = plist->next;
         }
         return true;
@@ -313,32 +468,26 @@ static bool do_option(int argc, char *argv[])
     for (int i = 1; i < argc; i++) {
         char *name = argv[i];
         int value = 0;
-        bool found = false;
         /* Get value from next argument */
         if (i + 1 >= argc) {
             report(1, "No value given for parameter %s", name);
             return false;
-        } else if (!get_int(argv[++i], &value)) {
-            report(1, "Cannot parse '%s' as integer", argv[i]);
-            return false;
         }
         /* Find parameter in list */
         param_element_t *plist = param_list;
-        while (!found && plist) {
-            if (strcmp(plist->name, name) == 0) {
-                int oldval = *plist->valp;
-                *plist->valp = value;
-                if (plist->setter)
-                    plist->setter(oldval);
-                found = true;
-            } else
-                plist = plist->next;
-        }
+        while (plist && strcmp(plist->name, name) != 0)
+            plist = plist->next;
         /* Didn't find parameter */
-        if (!found) {
+        if (!plist) {
             report(1, "Unknown parameter '%s'", name);
             return false;
         }
+        if (!get_param_value(plist, argv[++i], &value))
+            return false;
+        int oldval = *plist->valp;
+        *plist->valp = value;
+        if (plist->setter)
+            plist->setter(oldval);
     }
 
     return true;
@@ -420,6 +569,7 @@ static bool do_web(int argc, char *argv[])
 void init_cmd()
 {
     cmd_list = NULL;
+    clear_cmd_table();
     param_list = NULL;
     err_cnt = 0;
     quit_flag = false;
@@ -445,6 +595,293 @@ void init_cmd()
     first_time = last_time;
 }
 
+/* Open the cache of a file if it was compiled from its current content,
+ * otherwise start writing a new one under a temporary name
+ */
+static void cache_open(prog_t *p, const char *fname, const struct stat *st)
+{
+    cache_header_t want = {
+        .magic = CACHE_MAGIC,
+        .size = st->st_size,
+        .sec = st->st_mtim.tv_sec,
+        .nsec = st->st_mtim.tv_nsec,
+    };
+    cache_header_t got;
+    size_t len = strlen(fname) + sizeof(CACHE_SUFFIX);
+    p->cache_name = malloc_or_fail(len, "cache_open");
+    snprintf(p->cache_name, len, "%s" CACHE_SUFFIX, fname);
+
+    p->cache = fopen(p->cache_name, "rb");
+    if (p->cache) {
+        if (fread(&got, sizeof(got), 1, p->cache) == 1 &&
+            !memcmp(&got, &want, sizeof(got)))
+            return;
+        fclose(p->cache);
+        p->cache = NULL;
+    }
+
+    p->tmp_name = malloc_or_fail(len + 7, "cache_open");
+    snprintf(p->tmp_name, len + 7, "%s.XXXXXX", p->cache_name);
+    int fd = mkstemp(p->tmp_name);
+    if (fd >= 0 && !(p->cache = fdopen(fd, "wb")))
+        close(fd);
+    if (p->cache && fwrite(&want, sizeof(want), 1, p->cache) == 1)
+        return;
+    if (p->cache) {
+        fclose(p->cache);
+        p->cache = NULL;
+    }
+    if (fd >= 0)
+        unlink(p->tmp_name);
+    free_string(p->tmp_name);
+    free_string(p->cache_name);
+    p->cache_name = p->tmp_name = NULL;
+}
+
+/* Stop using the cache. One written gets its name if it is complete, one
+ * read is removed if it is not @complete.
+ */
+static void cache_close(prog_t *p, bool complete)
+{
+    if (!p->cache_name)
+        return;
+
+    bool ok = !fclose(p->cache) && complete;
+    if (p->tmp_name) {
+        if (!ok || rename(p->tmp_name, p->cache_name))
+            unlink(p->tmp_name);
+        free_string(p->tmp_name);
+    } else if (!complete) {
+        unlink(p->cache_name);
+    }
+    free_string(p->cache_name);
+    p->cache = NULL;
+    p->cache_name = p->tmp_name = NULL;
+}
+
+/* Write the block, or the end marker if it is empty */
+static void cache_write(prog_t *p)
+{
+    block_header_t h = {p->n, p->len, p->src_off};
+    bool ok = fwrite(&h, sizeof(h), 1, p->cache) == 1;
+    for (int i = 0; ok && i < p->n; i++) {
+        int32_t argc = p->insn[i].argc;
+        ok = fwrite(&argc, sizeof(argc), 1, p->cache) == 1;
+    }
+    if (!ok || fwrite(p->text, 1, p->len, p->cache) != p->len)
+        cache_close(p, false);
+    else if (!p->n)
+        cache_close(p, true);
+}
+
+/* Read the next block of the cache, leaving it empty at the end marker.
+ * Return false if the cache is cut short or does not fit the source.
+ */
+static bool cache_read(prog_t *p)
+{
+    block_header_t h;
+    if (fread(&h, sizeof(h), 1, p->cache) != 1)
+        return false;
+    if (!h.n)
+        return !h.len && h.src_end == p->src_size &&
+               getc(p->cache) == EOF && feof(p->cache);
+    if (h.n > PROG_INSN || h.len > PROG_TEXT || h.src_end <= p->src_off ||
+        h.src_end > p->src_size)
+        return false;
+
+    for (int i = 0; i < (int) h.n; i++) {
+        int32_t argc;
+        if (fread(&argc, sizeof(argc), 1, p->cache) != 1)
+            return false;
+        p->insn[i].argc = argc;
+    }
+    p->n = h.n;
+    p->len = h.len;
+    if (fread(p->text, 1, p->len, p->cache) != p->len)
+        return false;
+    p->src_off = h.src_end;
+    return true;
+}
+
+/* Compile the next lines of the source, as many as fit in the block. Lines
+ * are cut as readline() does.
+ */
+static void prog_compile(prog_t *p, int fd)
+{
+    while (p->n < PROG_INSN) {
+        char *start = p->src + p->pos;
+        size_t avail = p->end - p->pos;
+        char *nl = memchr(start, '\n', avail);
+        size_t len, used;
+        if (nl && nl - start < RIO_BUFSIZE - 2) {
+            len = nl - start;
+            used = len + 1;
+        } else if (avail >= RIO_BUFSIZE - 2) {
+            len = used = RIO_BUFSIZE - 2;
+        } else if (!p->eof) {
+            memmove(p->src, start, avail);
+            p->pos = 0;
+            p->end = avail;
+            ssize_t got = read(fd, p->src + avail, PROG_SRC - avail);
+            if (got > 0)
+                p->end += got;
+            else
+                p->eof = true;
+            continue;
+        } else if (avail) {
+            len = used = avail;
+        } else {
+            break;
+        }
+
+        /* The line and its arguments take at most 2 * len + 3 bytes */
+        if (PROG_TEXT - p->len < 2 * len + 3 ||
+            PROG_ARGS - p->argv_cnt < (len + 1) / 2)
+            break;
+
+        /* Echo stops at a null byte, the newline with it */
+        char *dst = p->text + p->len;
+        size_t shown = strnlen(start, len);
+        memcpy(dst, start, shown);
+        dst += shown;
+        if (shown == len)
+            *dst++ = '\n';
+        *dst++ = '\0';
+
+        /* Split into arguments as parse_args() does */
+        bool skipping = true;
+        int argc = 0;
+        for (size_t i = 0; i < len && start[i]; i++) {
+            int c = start[i];
+            if (isspace(c)) {
+                if (!skipping) {
+                    *dst++ = '\0';
+                    skipping = true;
+                }
+            } else {
+                if (skipping) {
+                    argc++;
+                    skipping = false;
+                }
+                *dst++ = c;
+            }
+        }
+        if (!skipping)
+            *dst++ = '\0';
+
+        p->insn[p->n++].argc = argc;
+        p->argv_cnt += argc;
+        p->len = dst - p->text;
+        p->pos += used;
+        p->src_off += used;
+    }
+}
+
+/* Point each line of the block at its text and arguments, and look up its
+ * command. Return false if the text does not match the argument counts.
+ */
+static bool prog_link(prog_t *p)
+{
+    char *src = p->text, *end = p->text + p->len;
+    size_t k = 0;
+    for (int i = 0; i < p->n; i++) {
+        insn_t *insn = &p->insn[i];
+        if (insn->argc < 0 || (size_t) insn->argc > PROG_ARGS - k)
+            return false;
+        insn->argv = p->argv + k;
+        for (int j = -1; j < insn->argc; j++) {
+            char *nul = memchr(src, '\0', end - src);
+            if (!nul)
+                return false;
+            if (j < 0)
+                insn->line = src;
+            else
+                p->argv[k++] = src;
+            src = nul + 1;
+        }
+        insn->cmd = insn->argc ? *cmd_slot(insn->argv[0]) : NULL;
+    }
+    return src == end;
+}
+
+/* Fill the block with the next lines of the cache. When the cache turns out
+ * to be damaged, remove it and compile the rest of the source.
+ */
+static bool prog_load(prog_t *p, int fd)
+{
+    int64_t src_off = p->src_off;
+    if (cache_read(p) && prog_link(p))
+        return true;
+
+    report(1, "Ignoring damaged cache of command file");
+    cache_close(p, false);
+    p->n = 0;
+    p->len = p->argv_cnt = 0;
+    p->src_off = src_off;
+    if (lseek(fd, src_off, SEEK_SET) != src_off) {
+        report(1, "Could not resume reading command file");
+        record_error();
+        return false;
+    }
+    return true;
+}
+
+/* Fill the block with the next lines of the file, from its cache if it is
+ * read. Return false at the end of the file.
+ */
+static bool prog_next(prog_t *p, int fd)
+{
+    p->n = p->pc = 0;
+    p->len = p->argv_cnt = 0;
+    if (p->cache && !p->tmp_name) {
+        if (!prog_load(p, fd))
+            return false;
+        if (p->n || p->cache) {
+            if (!p->n)
+                cache_close(p, true);
+            return p->n > 0;
+        }
+    }
+
+    prog_compile(p, fd);
+    if (p->tmp_name)
+        cache_write(p);
+    prog_link(p);
+    return p->n > 0;
+}
+
+/* Set up compiling a regular file, others are read a line at a time */
+static prog_t *prog_open(const char *fname, int fd)
+{
+    struct stat st;
+    if (fstat(fd, &st) || !S_ISREG(st.st_mode))
+        return NULL;
+
+    prog_t *p = malloc_or_fail(sizeof(prog_t), "prog_open");
+    p->n = p->pc = 0;
+    p->pos = p->end = 0;
+    p->eof = false;
+    p->src_off = 0;
+    p->src_size = st.st_size;
+    p->cache = NULL;
+    p->cache_name = p->tmp_name = NULL;
+    if (cmd_cache)
+        cache_open(p, fname, &st);
+    return p;
+}
+
+static void prog_free(prog_t *p)
+{
+    if (!p)
+        return;
+    /* A cache read partway is kept, one written partway is not */
+    if (p->tmp_name)
+        cache_close(p, false);
+    else if (p->cache_name)
+        cache_close(p, true);
+    free_block(p, sizeof(prog_t));
+}
+
 /* Create new buffer for named file.
  * Name == NULL for stdin.
  * Return true if successful.
@@ -463,20 +900,34 @@ static bool push_file(char *fname)
     rnew->fd = fd;
     rnew->count = 0;
     rnew->bufptr = rnew->buf;
+    rnew->prog = fname ? prog_open(fname, fd) : NULL;
+    rnew->busy = 0;
+    rnew->dropped = false;
     rnew->prev = buf_stack;
     buf_stack = rnew;
 
     return true;
 }
 
-/* Pop a file buffer from stack */
+static void free_file(rio_t *r)
+{
+    close(r->fd);
+    prog_free(r->prog);
+    free_block(r, sizeof(rio_t));
+}
+
+/* Pop a file buffer from stack. One whose command is running is freed once
+ * the command returns, as its arguments are still in use.
+ */
 static void pop_file()
 {
     if (buf_stack) {
         rio_t *rsave = buf_stack;
         buf_stack = rsave->prev;
-        close(rsave->fd);
-        free_block(rsave, sizeof(rio_t));
+        if (rsave->busy)
+            rsave->dropped = true;
+        else
+            free_file(rsave);
     }
 }
 
@@ -542,6 +993,37 @@ static char *readline()
     return linebuf;
 }
 
+/* Run the next command of the file on top of the stack */
+static void run_next()
+{
+    rio_t *r = buf_stack;
+    if (!r->prog) {
+        char *cmdline = readline();
+        if (cmdline)
+            interpret_cmd(cmdline);
+        return;
+    }
+
+    prog_t *p = r->prog;
+    if (p->pc == p->n && !prog_next(p, r->fd)) {
+        pop_file();
+        return;
+    }
+
+    insn_t *insn = &p->insn[p->pc++];
+    if (echo) {
+        report_noreturn(1, prompt);
+        report_noreturn(1, "%s", insn->line);
+    }
+    if (quit_flag)
+        return;
+
+    r->busy++;
+    run_cmd(insn->cmd, insn->argc, insn->argv);
+    if (!--r->busy && r->dropped)
+        free_file(r);
+}
+
 static bool cmd_done()
 {
     return !buf_stack || quit_flag;
@@ -590,9 +1072,7 @@ static int cmd_select(int nfds,
             fflush(stdout);
             prompt_flag = true;
         } else if (infd != STDIN_FILENO) {
-            char *cmdline = readline();
-            if (cmdline)
-                interpret_cmd(cmdline);
+            run_next();
         }
     }
     return 0;
@@ -603,6 +1083,9 @@ bool finish_cmd()
     bool ok = true;
     if (!quit_flag)
         ok = ok && do_quit(0, NULL);
+    /* Files left when stopping on errors, whose caches are incomplete */
+    while (buf_stack)
+        pop_file();
     has_infile = false;
     return ok && err_cnt == 0;
 }
@@ -677,3 +1160,32 @@ bool run_console(char *infile_name)
 
     return err_cnt == 0;
 }
+
+int cmd_error_count()
+{
+    return err_cnt;
+}
+
+bool cmd_quitting()
+{
+    return quit_flag;
+}
+
+bool run_source(char *fname)
+{
+    rio_t *outer = buf_stack;
+    bool outer_infile = has_infile;
+
+    if (!push_file(fname)) {
+        has_infile = outer_infile;
+        return false;
+    }
+
+    while (buf_stack != outer && !quit_flag)
+        run_next();
+    /* Drop the rest of the file when quitting halfway */
+    while (buf_stack != outer)
+        pop_file();
+    has_infile = outer_infile;
+    return true;
+}
@@ -34,6 +34,8 @@ typedef void (*setter_func_t)(int oldval);
 typedef struct __param_element {
     char *name;
     int *valp;
+    /* Names of the values of an enumerated parameter, NULL-terminated */
+    const char *const *names;
     char *summary;
     /* Function that gets called whenever parameter changes */
     setter_func_t setter;
@@ -50,6 +52,13 @@ void add_cmd(char *name, cmd_func_t operation, char *summary, char *parameter);
 /* Add a new parameter */
 void add_param(char *name, int *valp, char *summary, setter_func_t setter);
 
+/* Add a new parameter whose value is the index of one of the given names */
+void add_enum_param(char *name,
+                    int *valp,
+                    const char *const *names,
+                    char *summary,
+                    setter_func_t setter);
+
 /* Extract integer from text and store at loc */
 bool get_int(char *vname, int *loc);
 
@@ -59,6 +68,11 @@ void add_quit_helper(cmd_func_t qf);
 /* Turn echoing on/off */
 void set_echo(bool on);
 
+/* Turn on/off caching of compiled command files, next to them with suffix
+ * .bc, so that running a file again skips parsing it
+ */
+void set_cmd_cache(bool on);
+
 /* Complete command interpretation */
 
 /* Return true if no errors occurred */
@@ -68,6 +82,17 @@ bool finish_cmd();
  */
 bool run_console(char *infile_name);
 
+/* Run the commands of a file to its end, from within a command.
+ * Return false if the file cannot be opened
+ */
+bool run_source(char *fname);
+
+/* Number of commands that failed so far */
+int cmd_error_count();
+
+/* Return true once commands stop, on quit or past the error limit */
+bool cmd_quitting();
+
 /* Callback function to complete command by linenoise */
 void completion(const char *buf, line_completions_t *lc);
 
@@ -0,0 +1,292 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cqueue.h"
+
+#define cq_entry(h) container_of(h, cqueue_t, head)
+
+/* Create an empty queue */
+struct list_head *cq_new()
+{
+    cqueue_t *q = malloc(sizeof(cqueue_t));
+    if (!q)
+        return NULL;
+
+    INIT_LIST_HEAD(&q->head);
+    INIT_LIST_HEAD(&q->chunks);
+    q->size = 0;
+    return &q->head;
+}
+
+/* Free all storage used by queue */
+void cq_free(struct list_head *head)
+{
+    if (!head)
+        return;
+
+    cqueue_t *q = cq_entry(head);
+    cq_chunk_t *chunk, *safe;
+    list_for_each_entry_safe(chunk, safe, &q->chunks, list) {
+        for (unsigned int i = chunk->begin; i < chunk->end; i++)
+            free(chunk->slots[i]);
+        free(chunk);
+    }
+    free(q);
+}
+
+/* Add an empty chunk whose slots are used from @at onward */
+static cq_chunk_t *cq_chunk_new(cqueue_t *q, unsigned int at, bool tail)
+{
+    cq_chunk_t *chunk = malloc(sizeof(cq_chunk_t));
+    if (!chunk)
+        return NULL;
+
+    chunk->begin = chunk->end = at;
+    if (tail)
+        list_add_tail(&chunk->list, &q->chunks);
+    else
+        list_add(&chunk->list, &q->chunks);
+    return chunk;
+}
+
+/* Release @chunk once its last element is gone */
+static void cq_chunk_put(cq_chunk_t *chunk)
+{
+    if (chunk->begin == chunk->end) {
+        list_del(&chunk->list);
+        free(chunk);
+    }
+}
+
+/* Insert an element at head of queue */
+bool cq_insert_head(struct list_head *head, const char *s)
+{
+    if (!head || !s)
+        return false;
+
+    cqueue_t *q = cq_entry(head);
+    char *value = strdup(s);
+    if (!value)
+        return false;
+
+    cq_chunk_t *chunk = list_empty(&q->chunks)
+                            ? NULL
+                            : list_first_entry(&q->chunks, cq_chunk_t, list);
+    if (!chunk || !chunk->begin)
+        chunk = cq_chunk_new(q, CQ_CHUNK_SIZE, false);
+    if (!chunk) {
+        free(value);
+        return false;
+    }
+    chunk->slots[--chunk->begin] = value;
+    q->size++;
+    return true;
+}
+
+/* Insert an element at tail of queue */
+bool cq_insert_tail(struct list_head *head, const char *s)
+{
+    if (!head || !s)
+        return false;
+
+    cqueue_t *q = cq_entry(head);
+    char *value = strdup(s);
+    if (!value)
+        return false;
+
+    cq_chunk_t *chunk = list_empty(&q->chunks)
+                            ? NULL
+                            : list_last_entry(&q->chunks, cq_chunk_t, list);
+    if (!chunk || chunk->end == CQ_CHUNK_SIZE)
+        chunk = cq_chunk_new(q, 0, true);
+    if (!chunk) {
+        free(value);
+        return false;
+    }
+    chunk->slots[chunk->end++] = value;
+    q->size++;
+    return true;
+}
+
+/* Copy a removed string to @sp and release it */
+static void cq_release(cqueue_t *q, char *value, char *sp, size_t bufsize)
+{
+    if (sp && bufsize > 0) {
+        strncpy(sp, value, bufsize - 1);
+        sp[bufsize - 1] = '\0';
+    }
+    free(value);
+    q->size--;
+}
+
+/* Remove an element from head of queue */
+bool cq_remove_head(struct list_head *head, char *sp, size_t bufsize)
+{
+    if (!head || list_empty(&cq_entry(head)->chunks))
+        return false;
+
+    cqueue_t *q = cq_entry(head);
+    cq_chunk_t *chunk = list_first_entry(&q->chunks, cq_chunk_t, list);
+    cq_release(q, chunk->slots[chunk->begin++], sp, bufsize);
+    cq_chunk_put(chunk);
+    return true;
+}
+
+/* Remove an element from tail of queue */
+bool cq_remove_tail(struct list_head *head, char *sp, size_t bufsize)
+{
+    if (!head || list_empty(&cq_entry(head)->chunks))
+        return false;
+
+    cqueue_t *q = cq_entry(head);
+    cq_chunk_t *chunk = list_last_entry(&q->chunks, cq_chunk_t, list);
+    cq_release(q, chunk->slots[--chunk->end], sp, bufsize);
+    cq_chunk_put(chunk);
+    return true;
+}
+
+/* Return number of elements in queue */
+size_t cq_size(struct list_head *head)
+{
+    return head ? cq_entry(head)->size : 0;
+}
+
+/* Reverse the order of the chunks and the slots of every chunk */
+void cq_reverse(struct list_head *head)
+{
+    if (!head)
+        return;
+
+    cqueue_t *q = cq_entry(head);
+    struct list_head *node, *safe;
+    list_for_each_safe(node, safe, &q->chunks) {
+        cq_chunk_t *chunk = list_entry(node, cq_chunk_t, list);
+        for (unsigned int i = 0, j = CQ_CHUNK_SIZE - 1; i < j; i++, j--) {
+            char *tmp = chunk->slots[i];
+            chunk->slots[i] = chunk->slots[j];
+            chunk->slots[j] = tmp;
+        }
+        unsigned int begin = chunk->begin;
+        chunk->begin = CQ_CHUNK_SIZE - chunk->end;
+        chunk->end = CQ_CHUNK_SIZE - begin;
+        list_move(node, &q->chunks);
+    }
+}
+
+static int cmp_ascend(const void *a, const void *b)
+{
+    return strcmp(*(char *const *) a, *(char *const *) b);
+}
+
+static int cmp_descend(const void *a, const void *b)
+{
+    return strcmp(*(char *const *) b, *(char *const *) a);
+}
+
+/* Sort elements of queue in ascending/descending order */
+bool cq_sort(struct list_head *head, bool descend)
+{
+    if (!head || cq_entry(head)->size < 2)
+        return true;
+
+    cqueue_t *q = cq_entry(head);
+    char **values = malloc(q->size * sizeof(char *));
+    if (!values)
+        return false;
+
+    size_t n = 0;
+    cq_chunk_t *chunk;
+    list_for_each_entry(chunk, &q->chunks, list) {
+        memcpy(values + n, chunk->slots + chunk->begin,
+               (chunk->end - chunk->begin) * sizeof(char *));
+        n += chunk->end - chunk->begin;
+    }
+    qsort(values, n, sizeof(char *), descend ? cmp_descend : cmp_ascend);
+
+    n = 0;
+    list_for_each_entry(chunk, &q->chunks, list) {
+        memcpy(chunk->slots + chunk->begin, values + n,
+               (chunk->end - chunk->begin) * sizeof(char *));
+        n += chunk->end - chunk->begin;
+    }
+    free(values);
+    return true;
+}
+
+/* Delete all strings which appear more than once */
+bool cq_delete_dup(struct list_head *head)
+{
+    if (!head || list_empty(&cq_entry(head)->chunks))
+        return false;
+
+    /* Every string is kept or dropped once the next one is known. Kept strings
+     * are written back into the slots already read, in the same order.
+     */
+    cqueue_t *q = cq_entry(head);
+    cq_chunk_t *out = list_first_entry(&q->chunks, cq_chunk_t, list), *chunk;
+    unsigned int at = out->begin;
+    char *pending = NULL;
+    bool duplicate = false;
+    size_t kept = 0;
+
+    list_for_each_entry(chunk, &q->chunks, list) {
+        for (unsigned int i = chunk->begin; i < chunk->end; i++) {
+            char *value = chunk->slots[i];
+            if (pending && !strcmp(pending, value)) {
+                free(value);
+                duplicate = true;
+                continue;
+            }
+            if (pending && duplicate) {
+                free(pending);
+            } else if (pending) {
+                if (at == out->end) {
+                    out = list_entry(out->list.next, cq_chunk_t, list);
+                    at = out->begin;
+                }
+                out->slots[at++] = pending;
+                kept++;
+            }
+            pending = value;
+            duplicate = false;
+        }
+    }
+    if (duplicate) {
+        free(pending);
+    } else {
+        if (at == out->end) {
+            out = list_entry(out->list.next, cq_chunk_t, list);
+            at = out->begin;
+        }
+        out->slots[at++] = pending;
+        kept++;
+    }
+
+    /* Drop the chunks past the last string written */
+    out->end = at;
+    while (out->list.next != &q->chunks) {
+        chunk = list_entry(out->list.next, cq_chunk_t, list);
+        list_del(&chunk->list);
+        free(chunk);
+    }
+    cq_chunk_put(out);
+    q->size = kept;
+    return true;
+}
+
+/* Get the first elements of the queue */
+size_t cq_peek(struct list_head *head, const char **out, size_t n)
+{
+    if (!head)
+        return 0;
+
+    const cqueue_t *q = cq_entry(head);
+    const cq_chunk_t *chunk;
+    size_t got = 0;
+    list_for_each_entry(chunk, &q->chunks, list) {
+        for (unsigned int i = chunk->begin; i < chunk->end && got < n; i++)
+            out[got++] = chunk->slots[i];
+    }
+    return got;
+}
@@ -0,0 +1,152 @@
+#ifndef LAB0_CQUEUE_H
+#define LAB0_CQUEUE_H
+
+/* This program implements a queue of strings in linked chunks.
+ *
+ * It is an unrolled linked list: every node is a chunk holding up to
+ * CQ_CHUNK_SIZE strings, so the links and their cache misses are paid once
+ * per chunk instead of once per element, while growing never copies the
+ * elements already stored.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "harness.h"
+#include "list.h"
+
+/* Number of strings held by a chunk */
+#define CQ_CHUNK_SIZE 32
+
+/**
+ * cq_chunk_t - Chunk of consecutive elements
+ * @list: node linked into the chunks of the queue
+ * @begin: index of the first used slot
+ * @end: index past the last used slot
+ * @slots: the strings, slots outside [@begin, @end) are unused
+ *
+ * A chunk is never empty. New chunks at the head fill from the end of @slots
+ * and new chunks at the tail from its beginning.
+ */
+typedef struct {
+    struct list_head list;
+    unsigned int begin, end;
+    char *slots[CQ_CHUNK_SIZE];
+} cq_chunk_t;
+
+/**
+ * cqueue_t - Chunked queue
+ * @head: list head used as the handle of the queue, so that it can be kept
+ *        wherever a queue head is expected. It is never linked and always
+ *        looks like an empty list.
+ * @chunks: the chunks, first element first
+ * @size: number of elements
+ */
+typedef struct {
+    struct list_head head;
+    struct list_head chunks;
+    size_t size;
+} cqueue_t;
+
+/* Operations on chunked queue */
+
+/**
+ * cq_new() - Create an empty chunked queue
+ *
+ * Return: the handle of the queue, NULL for allocation failed
+ */
+struct list_head *cq_new();
+
+/**
+ * cq_free() - Free all storage used by the queue, no effect if @head is NULL
+ * @head: handle of the queue
+ */
+void cq_free(struct list_head *head);
+
+/**
+ * cq_insert_head() - Insert an element at the head
+ * @head: handle of the queue
+ * @s: string would be inserted
+ *
+ * Return: true for success, false for allocation failed or @head is NULL
+ */
+bool cq_insert_head(struct list_head *head, const char *s);
+
+/**
+ * cq_insert_tail() - Insert an element at the tail
+ * @head: handle of the queue
+ * @s: string would be inserted
+ *
+ * Return: true for success, false for allocation failed or @head is NULL
+ */
+bool cq_insert_tail(struct list_head *head, const char *s);
+
+/**
+ * cq_remove_head() - Remove and release the element from head of the queue
+ * @head: handle of the queue
+ * @sp: output buffer where the removed string is copied
+ * @bufsize: size of the string
+ *
+ * Return: true for success, false if queue is NULL or empty.
+ */
+bool cq_remove_head(struct list_head *head, char *sp, size_t bufsize);
+
+/**
+ * cq_remove_tail() - Remove and release the element from tail of the queue
+ * @head: handle of the queue
+ * @sp: output buffer where the removed string is copied
+ * @bufsize: size of the string
+ *
+ * Return: true for success, false if queue is NULL or empty.
+ */
+bool cq_remove_tail(struct list_head *head, char *sp, size_t bufsize);
+
+/**
+ * cq_size() - Get the number of elements in the queue
+ * @head: handle of the queue
+ *
+ * Return: the number of elements, zero if queue is NULL or empty
+ */
+size_t cq_size(struct list_head *head);
+
+/**
+ * cq_reverse() - Reverse elements in the queue
+ * @head: handle of the queue
+ */
+void cq_reverse(struct list_head *head);
+
+/**
+ * cq_sort() - Sort elements of the queue in ascending/descending order
+ * @head: handle of the queue
+ * @descend: whether or not to sort in descending order
+ *
+ * The strings are gathered into an array sorted with qsort(), which is not
+ * stable, and put back into the same slots.
+ *
+ * Return: true for success, false for allocation failed
+ */
+bool cq_sort(struct list_head *head, bool descend);
+
+/**
+ * cq_delete_dup() - Delete all strings of the sorted queue which appear more
+ * than once
+ * @head: handle of the queue
+ *
+ * The remaining strings are packed towards the head and the chunks left empty
+ * are released.
+ *
+ * Return: true for success, false if queue is NULL or empty.
+ */
+bool cq_delete_dup(struct list_head *head);
+
+/**
+ * cq_peek() - Get the first elements of the queue
+ * @head: handle of the queue
+ * @out: array receiving pointers to the strings, from the head onward
+ * @n: capacity of @out
+ *
+ * Return: the number of strings stored in @out
+ */
+size_t cq_peek(struct list_head *head, const char **out, size_t n);
+
+#endif /* LAB0_CQUEUE_H */
@@ -2,39 +2,51 @@
 #include <stdint.h>
 #include <string.h>
 
+#include "backend.h"
 #include "constant.h"
 #include "cpucycles.h"
 #include "queue.h"
 #include "random.h"
 
 /* Maintain a queue independent from the qtest since
- * we do not want the test to affect the original functionality
+ * we do not want the test to affect the original functionality.
+ * It is created by the backend selected in qtest.
  */
 static struct list_head *l = NULL;
 
-#define dut_new() ((void) (l = q_new()))
+#define dut_new() ((void) (l = queue_backend->new()))
+
+#define dut_count() ((int) queue_backend->size(l))
 
 #define dut_size(n)                                \
     do {                                           \
         for (int __iter = 0; __iter < n; ++__iter) \
-            q_size(l);                             \
+            queue_backend->size(l);                \
     } while (0)
 
-#define dut_insert_head(s, n)    \
-    do {                         \
-        int j = n;               \
-        while (j--)              \
-            q_insert_head(l, s); \
+#define dut_insert_head(s, n)                 \
+    do {                                      \
+        int j = n;                            \
+        while (j--)                           \
+            queue_backend->insert_head(l, s); \
     } while (0)
 
-#define dut_insert_tail(s, n)    \
-    do {                         \
-        int j = n;               \
-        while (j--)              \
-            q_insert_tail(l, s); \
+#define dut_insert_tail(s, n)                 \
+    do {                                      \
+        int j = n;                            \
+        while (j--)                           \
+            queue_backend->insert_tail(l, s); \
     } while (0)
 
-#define dut_free() ((void) (q_free(l)))
+/* The list of queue.c hands the removed element back, so that it is released
+ * past the measurement. Other backends release it as part of the removal.
+ */
+#define dut_remove(pos, e)                         \
+    (queue_backend == queue_backends[0]            \
+         ? (void) (e = q_remove_##pos(l, NULL, 0)) \
+         : (void) queue_backend->remove_##pos(l, NULL, 0))
+
+#define dut_free() ((void) (queue_backend->release(l)))
 
 static char random_string[N_MEASURES][8];
 static int random_string_iter = 0;
@@ -83,11 +95,11 @@ bool measure(int64_t *before_ticks,
             dut_insert_head(
                 get_random_string(),
                 *(uint16_t *) (input_data + i * CHUNK_SIZE) % 10000);
-            int before_size = q_size(l);
+            int before_size = dut_count();
             before_ticks[i] = cpucycles();
             dut_insert_head(s, 1);
             after_ticks[i] = cpucycles();
-            int after_size = q_size(l);
+            int after_size = dut_count();
             dut_free();
             if (before_size != after_size - 1)
                 return false;
@@ -100,11 +112,11 @@ bool measure(int64_t *before_ticks,
             dut_insert_head(
                 get_random_string(),
                 *(uint16_t *) (input_data + i * CHUNK_SIZE) % 10000);
-            int before_size = q_size(l);
+            int before_size = dut_count();
             before_ticks[i] = cpucycles();
             dut_insert_tail(s, 1);
             after_ticks[i] = cpucycles();
-            int after_size = q_size(l);
+            int after_size = dut_count();
             dut_free();
             if (before_size != after_size - 1)
                 return false;
@@ -116,11 +128,12 @@ bool measure(int64_t *before_ticks,
             dut_insert_head(
                 get_random_string(),
                 *(uint16_t *) (input_data + i * CHUNK_SIZE) % 10000 + 1);
-            int before_size = q_size(l);
+            int before_size = dut_count();
+            element_t *e = NULL;
             before_ticks[i] = cpucycles();
-            element_t *e = q_remove_head(l, NULL, 0);
+            dut_remove(head, e);
             after_ticks[i] = cpucycles();
-            int after_size = q_size(l);
+            int after_size = dut_count();
             if (e)
                 q_release_element(e);
             dut_free();
@@ -134,11 +147,12 @@ bool measure(int64_t *before_ticks,
             dut_insert_head(
                 get_random_string(),
                 *(uint16_t *) (input_data + i * CHUNK_SIZE) % 10000 + 1);
-            int before_size = q_size(l);
+            int before_size = dut_count();
+            element_t *e = NULL;
             before_ticks[i] = cpucycles();
-            element_t *e = q_remove_tail(l, NULL, 0);
+            dut_remove(tail, e);
             after_ticks[i] = cpucycles();
-            int after_size = q_size(l);
+            int after_size = dut_count();
             if (e)
                 q_release_element(e);
             dut_free();
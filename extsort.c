@@ -0,0 +1,119 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "extsort.h"
+#include "queue.h"
+#include "stats.h"
+
+size_t ext_sort_budget = 0;
+
+static inline int run_cmp(void *priv,
+                          const struct list_head *a,
+                          const struct list_head *b)
+{
+    STATS_INC(compares);
+    int cmp = strcmp(list_entry(a, element_t, list)->value,
+                     list_entry(b, element_t, list)->value);
+    return *(const bool *) priv ? -cmp : cmp;
+}
+
+LIST_SORT_DEFINE(run_sort, run_cmp)
+
+/* Order runs by their first string, then by position to keep the sort stable
+ */
+static inline bool run_before(const struct list_head *runs,
+                              int a,
+                              int b,
+                              bool descend)
+{
+    STATS_INC(compares);
+    int cmp = strcmp(list_first_entry(&runs[a], element_t, list)->value,
+                     list_first_entry(&runs[b], element_t, list)->value);
+    if (descend)
+        cmp = -cmp;
+    return cmp < 0 || (!cmp && a < b);
+}
+
+static void heap_down(const struct list_head *runs,
+                      int *heap,
+                      int n,
+                      int i,
+                      bool descend)
+{
+    for (int child; (child = 2 * i + 1) < n; i = child) {
+        if (child + 1 < n &&
+            run_before(runs, heap[child + 1], heap[child], descend))
+            child++;
+        if (!run_before(runs, heap[child], heap[i], descend))
+            break;
+        int tmp = heap[i];
+        heap[i] = heap[child];
+        heap[child] = tmp;
+    }
+}
+
+/* Sort a queue in runs of at most @budget bytes of strings */
+bool ext_sort(struct list_head *head, bool descend, size_t budget)
+{
+    if (!head || !budget)
+        return false;
+
+    /* Count the runs the queue is cut into, each filled up to the budget */
+    size_t total = 0, bytes = 0;
+    int k = 0;
+    element_t *e;
+    list_for_each_entry(e, head, list) {
+        size_t size = strlen(e->value) + 1;
+        if (!k || bytes + size > budget) {
+            k++;
+            bytes = 0;
+        }
+        bytes += size;
+        total += size;
+    }
+    if (total <= budget)
+        return false;
+
+    struct list_head *runs = malloc(k * sizeof(struct list_head));
+    int *heap = malloc(k * sizeof(int));
+    if (!runs || !heap) {
+        free(runs);
+        free(heap);
+        return false;
+    }
+
+    /* The elements are parked in the runs until the merge links them back,
+     * leaving the sort halfway would drop them from the queue.
+     */
+    exception_hold();
+    for (int i = 0; i < k; i++) {
+        struct list_head *r = &runs[i];
+        INIT_LIST_HEAD(r);
+        for (bytes = 0; !list_empty(head);) {
+            e = list_first_entry(head, element_t, list);
+            size_t size = strlen(e->value) + 1;
+            if (!list_empty(r) && bytes + size > budget)
+                break;
+            bytes += size;
+            list_move_tail(&e->list, r);
+        }
+        run_sort(&descend, r);
+        heap[i] = i;
+    }
+
+    int n = k;
+    for (int i = n / 2 - 1; i >= 0; i--)
+        heap_down(runs, heap, n, i, descend);
+    while (n) {
+        struct list_head *r = &runs[heap[0]];
+        list_move_tail(r->next, head);
+        if (list_empty(r))
+            heap[0] = heap[--n];
+        heap_down(runs, heap, n, 0, descend);
+    }
+
+    free(runs);
+    free(heap);
+    exception_release();
+    return true;
+}
@@ -0,0 +1,43 @@
+#ifndef LAB0_EXTSORT_H
+#define LAB0_EXTSORT_H
+
+/* This program sorts queues of strings larger than a budget in runs.
+ *
+ * The queue is cut into runs whose strings fit in the budget, so that each
+ * run is sorted within the cache it is sized for, and a k-way merge links the
+ * runs back into the queue. Elements keep their strings, so interned strings
+ * stay shared.
+ *
+ * The runs are not spilled to a file. The queue holds every string before
+ * and after the sort, so no budget can lower the peak memory, and a round
+ * trip through the disk would only add time and an allocation per element.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "list.h"
+
+/**
+ * ext_sort_budget - Bytes of strings in each run q_sort() sorts on its own
+ *
+ * Queues whose strings, counting their terminating null bytes, take more
+ * than this are sorted by ext_sort(). Zero, the default, means no limit.
+ */
+extern size_t ext_sort_budget;
+
+/**
+ * ext_sort() - Sort a queue of element_t in runs merged back together
+ * @head: header of queue
+ * @descend: whether to sort the queue in descending order
+ * @budget: bytes of strings per run
+ *
+ * The sort is stable. Exceptions raised by the time limit are held until it
+ * is done, since the elements are out of the queue while the runs are merged.
+ *
+ * Return: true if the queue was sorted, false if it fits in @budget or the
+ * runs could not be allocated, in which case the queue is left untouched
+ */
+bool ext_sort(struct list_head *head, bool descend, size_t budget);
+
+#endif /* LAB0_EXTSORT_H */
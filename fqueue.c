@@ -0,0 +1,429 @@
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "fqueue.h"
+
+#define fq_entry(h) container_of(h, fqueue_t, head)
+
+/* The header takes a page of its own, so that syncing it writes nothing else
+ */
+#define FQ_HEADER_SIZE 4096
+
+/* Size of a new file */
+#define FQ_INIT_SIZE (1 << 20)
+
+#define FQ_MAGIC "lab0-fq2"
+
+/**
+ * fq_header_t - First page of the file
+ * @magic: FQ_MAGIC, identifying the format
+ * @meta: two copies of the metadata
+ */
+typedef struct {
+    char magic[8];
+    fq_meta_t meta[2];
+} fq_header_t;
+
+#define fq_header(q) ((fq_header_t *) (q)->base)
+#define fq_node(q, off) ((fq_node_t *) ((q)->base + (off)))
+
+/* Bytes taken by a node holding a string of @len bytes with its null byte */
+static inline size_t fq_node_size(size_t len)
+{
+    return (sizeof(fq_node_t) + len + 7) & ~(size_t) 7;
+}
+
+/* FNV-1a hash of the metadata but its checksum */
+static uint64_t fq_checksum(const fq_meta_t *meta)
+{
+    const unsigned char *p = (const unsigned char *) meta;
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (size_t i = 0; i < offsetof(fq_meta_t, checksum); i++)
+        hash = (hash ^ p[i]) * 0x100000001b3ULL;
+    return hash;
+}
+
+/* Read link @d of the node at @off */
+static inline uint64_t fq_get(const fqueue_t *q, uint64_t off, int d)
+{
+    if (off == q->meta.fix[d].node)
+        return q->meta.fix[d].to;
+    return fq_node(q, off)->link[d];
+}
+
+/* Write link @d of the node at @off, in the metadata for a synced node */
+static inline void fq_set(fqueue_t *q, uint64_t off, int d, uint64_t to)
+{
+    if (off < q->synced) {
+        q->meta.fix[d].node = off;
+        q->meta.fix[d].to = to;
+    } else {
+        fq_node(q, off)->link[d] = to;
+    }
+}
+
+/* Write the metadata to the copy in the header not written last */
+static bool fq_write_meta(fqueue_t *q, fq_meta_t *meta)
+{
+    fq_meta_t *copy = &fq_header(q)->meta[!q->slot];
+    meta->seq++;
+    *copy = *meta;
+    copy->checksum = fq_checksum(copy);
+    if (msync(q->base, FQ_HEADER_SIZE, MS_SYNC))
+        return false;
+    q->slot = !q->slot;
+    return true;
+}
+
+static bool fq_map(fqueue_t *q, size_t length)
+{
+    void *base =
+        mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_SHARED, q->fd, 0);
+    if (base == MAP_FAILED)
+        return false;
+    if (q->base)
+        munmap(q->base, q->length);
+    q->base = base;
+    q->length = length;
+    return true;
+}
+
+/* Lay out an empty queue in a new file */
+static bool fq_format(fqueue_t *q)
+{
+    if (ftruncate(q->fd, FQ_INIT_SIZE) || !fq_map(q, FQ_INIT_SIZE))
+        return false;
+
+    fq_header_t *h = fq_header(q);
+    memset(h, 0, sizeof(fq_header_t));
+    memcpy(h->magic, FQ_MAGIC, sizeof(h->magic));
+    q->slot = 1;
+    q->meta.brk = q->synced = FQ_HEADER_SIZE;
+    return fq_write_meta(q, &q->meta);
+}
+
+/* Pick the metadata in effect, checking it fits the file */
+static bool fq_load(fqueue_t *q, size_t length)
+{
+    if (length < FQ_HEADER_SIZE || !fq_map(q, length))
+        return false;
+
+    const fq_header_t *h = fq_header(q);
+    if (memcmp(h->magic, FQ_MAGIC, sizeof(h->magic)))
+        return false;
+
+    q->slot = -1;
+    for (int i = 0; i < 2; i++) {
+        const fq_meta_t *meta = &h->meta[i];
+        if (meta->checksum != fq_checksum(meta) ||
+            meta->brk < FQ_HEADER_SIZE || meta->brk > length ||
+            meta->live > meta->brk - FQ_HEADER_SIZE ||
+            meta->ends[0] >= meta->brk || meta->ends[1] >= meta->brk)
+            continue;
+        if (q->slot < 0 || meta->seq > h->meta[q->slot].seq)
+            q->slot = i;
+    }
+    if (q->slot < 0)
+        return false;
+    q->meta = h->meta[q->slot];
+    q->synced = q->meta.brk;
+    return true;
+}
+
+static struct list_head *fq_attach(int fd)
+{
+    /* A second handle would allocate nodes over those of the first */
+    if (flock(fd, LOCK_EX | LOCK_NB)) {
+        close(fd);
+        return NULL;
+    }
+
+    fqueue_t *q = malloc(sizeof(fqueue_t));
+    if (!q) {
+        close(fd);
+        return NULL;
+    }
+    memset(q, 0, sizeof(fqueue_t));
+    q->fd = fd;
+
+    struct stat st;
+    bool ok = !fstat(fd, &st) &&
+              (st.st_size ? fq_load(q, st.st_size) : fq_format(q));
+    if (!ok) {
+        fq_free(&q->head);
+        return NULL;
+    }
+
+    INIT_LIST_HEAD(&q->head);
+    return &q->head;
+}
+
+/* Open a queue stored in a file */
+struct list_head *fq_open(const char *path)
+{
+    if (!path)
+        return NULL;
+
+    int fd = open(path, O_RDWR | O_CREAT, 0644);
+    return fd < 0 ? NULL : fq_attach(fd);
+}
+
+/* Create a queue in a temporary file, removed as soon as it is created */
+struct list_head *fq_new()
+{
+    char path[] = "/tmp/lab0-fq.XXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0)
+        return NULL;
+    unlink(path);
+    return fq_attach(fd);
+}
+
+/* Grow the file to hold @end bytes at least */
+static bool fq_reserve(fqueue_t *q, uint64_t end)
+{
+    if (end <= q->length)
+        return true;
+
+    size_t length = q->length * 2;
+    while (end > length)
+        length *= 2;
+    /* Offsets keep the nodes valid wherever the file is mapped again */
+    return !ftruncate(q->fd, length) && fq_map(q, length);
+}
+
+/* Copy the nodes of the queue in order to @to and commit the copies. No node
+ * committed last may lie in the space they are copied to.
+ */
+static bool fq_move(fqueue_t *q, uint64_t to)
+{
+    if (!fq_reserve(q, to + q->meta.live))
+        return false;
+
+    fq_meta_t meta = q->meta;
+    uint64_t from = meta.ends[0], prev = 0, dst = to;
+    for (uint64_t i = 0; i < meta.size; i++) {
+        const fq_node_t *node = fq_node(q, from);
+        size_t len = strlen(node->value) + 1;
+        fq_node_t *copy = fq_node(q, dst);
+        copy->link[0] = dst + fq_node_size(len);
+        copy->link[1] = prev;
+        memcpy(copy->value, node->value, len);
+        prev = dst;
+        dst = copy->link[0];
+        from = fq_get(q, from, 0);
+    }
+    fq_node(q, prev)->link[0] = 0;
+
+    meta.ends[0] = to;
+    meta.ends[1] = prev;
+    meta.brk = dst;
+    memset(meta.fix, 0, sizeof(meta.fix));
+    if (msync(q->base, dst, MS_SYNC) || !fq_write_meta(q, &meta))
+        return false;
+    q->meta = meta;
+    q->synced = meta.brk;
+    return true;
+}
+
+/* Move the nodes past the end of the file then back to its start, once most
+ * of it is garbage, and shrink the file to twice what is in use.
+ */
+static void fq_compact(fqueue_t *q)
+{
+    uint64_t used = q->meta.brk - FQ_HEADER_SIZE;
+    if (q->meta.size && used >= FQ_INIT_SIZE && used >= 4 * q->meta.live &&
+        (!fq_move(q, q->meta.brk) || !fq_move(q, FQ_HEADER_SIZE)))
+        return;
+
+    size_t length = FQ_INIT_SIZE;
+    while (length < 2 * q->meta.brk)
+        length *= 2;
+    if (length < q->length && fq_map(q, length))
+        (void) !ftruncate(q->fd, length);
+}
+
+/* Make the queue durable: nodes first, then the metadata pointing to them */
+bool fq_sync(struct list_head *head)
+{
+    if (!head)
+        return false;
+
+    fqueue_t *q = fq_entry(head);
+    if (msync(q->base, q->meta.brk, MS_SYNC))
+        return false;
+
+    /* Nothing is left to keep once the queue is empty */
+    fq_meta_t meta = q->meta;
+    if (!meta.size) {
+        meta.brk = FQ_HEADER_SIZE;
+        memset(meta.fix, 0, sizeof(meta.fix));
+    }
+    if (!fq_write_meta(q, &meta))
+        return false;
+
+    /* The nodes can take their fixed links over from the metadata now that
+     * it holds the same ones, and the next sync makes them durable.
+     */
+    for (int d = 0; d < 2; d++) {
+        if (meta.fix[d].node)
+            fq_node(q, meta.fix[d].node)->link[d] = meta.fix[d].to;
+    }
+    memset(meta.fix, 0, sizeof(meta.fix));
+    q->meta = meta;
+    q->synced = meta.brk;
+
+    fq_compact(q);
+    return true;
+}
+
+/* Unmap and close the file, discarding what was not synced */
+void fq_free(struct list_head *head)
+{
+    if (!head)
+        return;
+
+    fqueue_t *q = fq_entry(head);
+    if (q->base)
+        munmap(q->base, q->length);
+    close(q->fd);
+    free(q);
+}
+
+/* Allocate a node holding a copy of @s, growing the file if needed.
+ * Return its offset, 0 on failure.
+ */
+static uint64_t fq_alloc(fqueue_t *q, const char *s)
+{
+    size_t len = strlen(s) + 1;
+    size_t size = fq_node_size(len);
+    if (!fq_reserve(q, q->meta.brk + size))
+        return 0;
+
+    uint64_t off = q->meta.brk;
+    fq_node_t *node = fq_node(q, off);
+    node->link[0] = node->link[1] = 0;
+    memcpy(node->value, s, len);
+    q->meta.brk += size;
+    q->meta.live += size;
+    return off;
+}
+
+/* Insert a copy of @s at end @e of the queue, 0 for the first one */
+static bool fq_insert(fqueue_t *q, const char *s, int e)
+{
+    uint64_t off = fq_alloc(q, s);
+    if (!off)
+        return false;
+
+    fq_node_t *node = fq_node(q, off);
+    if (q->meta.size) {
+        uint64_t end = q->meta.ends[e];
+        node->link[e] = end;
+        fq_set(q, end, !e, off);
+    } else {
+        q->meta.ends[!e] = off;
+    }
+    q->meta.ends[e] = off;
+    q->meta.size++;
+    return true;
+}
+
+/* Insert an element at head of queue */
+bool fq_insert_head(struct list_head *head, const char *s)
+{
+    if (!head || !s)
+        return false;
+
+    fqueue_t *q = fq_entry(head);
+    return fq_insert(q, s, q->meta.reversed);
+}
+
+/* Insert an element at tail of queue */
+bool fq_insert_tail(struct list_head *head, const char *s)
+{
+    if (!head || !s)
+        return false;
+
+    fqueue_t *q = fq_entry(head);
+    return fq_insert(q, s, !q->meta.reversed);
+}
+
+/* Unlink the node at end @e, copying its string to @sp. No node is written,
+ * the last sync may still rely on it.
+ */
+static bool fq_remove(fqueue_t *q, int e, char *sp, size_t bufsize)
+{
+    if (!q->meta.size)
+        return false;
+
+    const fq_node_t *node = fq_node(q, q->meta.ends[e]);
+    if (sp && bufsize > 0) {
+        strncpy(sp, node->value, bufsize - 1);
+        sp[bufsize - 1] = '\0';
+    }
+    q->meta.live -= fq_node_size(strlen(node->value) + 1);
+
+    if (--q->meta.size)
+        q->meta.ends[e] = fq_get(q, q->meta.ends[e], e);
+    else
+        q->meta.ends[0] = q->meta.ends[1] = 0;
+    return true;
+}
+
+/* Remove an element from head of queue */
+bool fq_remove_head(struct list_head *head, char *sp, size_t bufsize)
+{
+    if (!head)
+        return false;
+
+    fqueue_t *q = fq_entry(head);
+    return fq_remove(q, q->meta.reversed, sp, bufsize);
+}
+
+/* Remove an element from tail of queue */
+bool fq_remove_tail(struct list_head *head, char *sp, size_t bufsize)
+{
+    if (!head)
+        return false;
+
+    fqueue_t *q = fq_entry(head);
+    return fq_remove(q, !q->meta.reversed, sp, bufsize);
+}
+
+/* Return number of elements in queue */
+size_t fq_size(struct list_head *head)
+{
+    return head ? fq_entry(head)->meta.size : 0;
+}
+
+/* Reverse elements by swapping which end is the head */
+void fq_reverse(struct list_head *head)
+{
+    if (head)
+        fq_entry(head)->meta.reversed ^= 1;
+}
+
+/* Get the first elements of queue */
+size_t fq_peek(struct list_head *head, const char **out, size_t n)
+{
+    if (!head)
+        return 0;
+
+    const fqueue_t *q = fq_entry(head);
+    int e = q->meta.reversed;
+    uint64_t off = q->meta.ends[e];
+    size_t got = 0;
+    for (; got < n && got < q->meta.size; got++) {
+        const fq_node_t *node = fq_node(q, off);
+        out[got] = node->value;
+        off = fq_get(q, off, e);
+    }
+    return got;
+}
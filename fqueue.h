@@ -0,0 +1,200 @@
+#ifndef LAB0_FQUEUE_H
+#define LAB0_FQUEUE_H
+
+/* This program implements a queue of strings stored in a memory-mapped file.
+ *
+ * Nodes and their strings are allocated in the file and link to each other
+ * by offsets from its start, so the file can be mapped anywhere and a queue
+ * is reopened in O(1) without reading its elements.
+ *
+ * Changes become durable at fq_sync(). Until then the file keeps describing
+ * the queue as of the last sync, even across a crash: nodes which were part
+ * of it are never written again, and the header holds two copies of the
+ * metadata, each with a checksum, a sync writing the older one once the
+ * nodes are on disk. Since only the ends of the queue change, the nodes kept
+ * from the last sync stay consecutive, and at most one of their links per
+ * direction differs from the file: these two links are kept in the metadata.
+ *
+ * Nodes are allocated past the last one, so removed nodes leave garbage
+ * behind. Once it outweighs the queue, a sync compacts the file: it copies
+ * the nodes past the end and commits them, then copies them back to the
+ * start of the file and commits again, each copy landing where no committed
+ * node lies. The file is then shrunk, keeping its size proportional to the
+ * queue.
+ *
+ * A file is locked while it is open, so that a single handle allocates in it.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "harness.h"
+#include "list.h"
+
+/**
+ * fq_node_t - Node in the file, followed by its null-terminated string
+ * @link: offsets of the neighbours, link @i stepping away from end @i of the
+ *        queue, see fq_meta_t
+ */
+typedef struct {
+    uint64_t link[2];
+    char value[];
+} fq_node_t;
+
+/**
+ * fq_meta_t - Metadata describing the queue
+ * @seq: number of metadata writes so far, the valid copy with the highest
+ *       one is in effect
+ * @ends: offsets of the first and the last node, 0 if the queue is empty
+ * @size: number of elements
+ * @brk: offset where the next node is allocated
+ * @live: bytes taken by the nodes of the queue, telling how much of the
+ *        space below @brk is garbage
+ * @fix: for each direction, a node whose link is not the one in the file,
+ *       0 for none, and the link to use instead
+ * @reversed: whether the head is the last node
+ * @checksum: hash of the fields above, to detect a torn write
+ */
+typedef struct {
+    uint64_t seq;
+    uint64_t ends[2];
+    uint64_t size, brk, live;
+    struct {
+        uint64_t node, to;
+    } fix[2];
+    uint64_t reversed;
+    uint64_t checksum;
+} fq_meta_t;
+
+/**
+ * fqueue_t - File-backed queue
+ * @head: list head used as the handle of the queue, so that it can be kept
+ *        wherever a queue head is expected. It is never linked and always
+ *        looks like an empty list.
+ * @fd: the file
+ * @base: where the file is mapped
+ * @length: number of bytes mapped, the size of the file
+ * @meta: current metadata, only written to the file by fq_sync()
+ * @synced: nodes below this offset were written before the last sync and
+ *          are not written again
+ * @slot: copy of the metadata in the header written last
+ */
+typedef struct {
+    struct list_head head;
+    int fd;
+    char *base;
+    size_t length;
+    fq_meta_t meta;
+    uint64_t synced;
+    int slot;
+} fqueue_t;
+
+/* Operations on file-backed queue */
+
+/**
+ * fq_open() - Open a queue stored in a file
+ * @path: name of the file, created holding an empty queue if it is missing
+ *        or empty
+ *
+ * The queue is as of the last fq_sync() done on the file.
+ *
+ * Return: the handle of the queue, NULL if the file cannot be opened, is
+ * open already, is not a queue or allocation failed
+ */
+struct list_head *fq_open(const char *path);
+
+/**
+ * fq_new() - Create an empty queue in an unnamed temporary file
+ *
+ * Return: the handle of the queue, NULL on failure
+ */
+struct list_head *fq_new();
+
+/**
+ * fq_sync() - Make the current content of the queue durable
+ * @head: handle of the queue
+ *
+ * Compacts the file when most of it is garbage, which takes time linear in
+ * the size of the queue but is amortized over the removals that caused it.
+ *
+ * Return: true for success, false if @head is NULL or writing failed, in
+ * which case the file still holds the queue as of the previous sync
+ */
+bool fq_sync(struct list_head *head);
+
+/**
+ * fq_free() - Unmap and close the file, no effect if @head is NULL
+ * @head: handle of the queue
+ *
+ * Changes since the last fq_sync() are discarded.
+ */
+void fq_free(struct list_head *head);
+
+/**
+ * fq_insert_head() - Insert an element at the head
+ * @head: handle of the queue
+ * @s: string would be inserted
+ *
+ * Return: true for success, false if the file cannot grow or @head is NULL
+ */
+bool fq_insert_head(struct list_head *head, const char *s);
+
+/**
+ * fq_insert_tail() - Insert an element at the tail
+ * @head: handle of the queue
+ * @s: string would be inserted
+ *
+ * Return: true for success, false if the file cannot grow or @head is NULL
+ */
+bool fq_insert_tail(struct list_head *head, const char *s);
+
+/**
+ * fq_remove_head() - Remove the element from head of the queue
+ * @head: handle of the queue
+ * @sp: output buffer where the removed string is copied
+ * @bufsize: size of the string
+ *
+ * Return: true for success, false if queue is NULL or empty.
+ */
+bool fq_remove_head(struct list_head *head, char *sp, size_t bufsize);
+
+/**
+ * fq_remove_tail() - Remove the element from tail of the queue
+ * @head: handle of the queue
+ * @sp: output buffer where the removed string is copied
+ * @bufsize: size of the string
+ *
+ * Return: true for success, false if queue is NULL or empty.
+ */
+bool fq_remove_tail(struct list_head *head, char *sp, size_t bufsize);
+
+/**
+ * fq_size() - Get the number of elements in the queue
+ * @head: handle of the queue
+ *
+ * Return: the number of elements, zero if queue is NULL or empty
+ */
+size_t fq_size(struct list_head *head);
+
+/**
+ * fq_reverse() - Reverse elements in the queue
+ * @head: handle of the queue
+ *
+ * Only flips which end is the head, no node is written.
+ */
+void fq_reverse(struct list_head *head);
+
+/**
+ * fq_peek() - Get the first elements of the queue
+ * @head: handle of the queue
+ * @out: array receiving pointers to the strings, from the head onward
+ * @n: capacity of @out
+ *
+ * The pointers are into the mapping and only valid until the next insertion.
+ *
+ * Return: the number of strings stored in @out
+ */
+size_t fq_peek(struct list_head *head, const char **out, size_t n);
+
+#endif /* LAB0_FQUEUE_H */
@@ -1,7 +1,9 @@
 /* Test support code */
 
+#include <pthread.h>
 #include <setjmp.h>
 #include <signal.h>
+#include <stdatomic.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -19,6 +21,12 @@
 /* Value at start of every allocated block */
 #define MAGICHEADER 0xdeadbeef
 
+/* Value at start of every interned string block */
+#define MAGICINTERN 0xfeedbeef
+
+/* Value at start of every block carved from an arena */
+#define MAGICARENA 0xdeadfeed
+
 /* Value when deallocate block */
 #define MAGICFREE 0xffffffff
 
@@ -41,6 +49,20 @@ typedef struct __block_element {
     /* Also place magic number at tail of every block */
 } block_element_t;
 
+/* Blocks carved from an arena keep a pointer to it past their footer, and
+ * each of them takes a multiple of ARENA_ALIGN bytes of the area.
+ */
+#define ARENA_ALIGN 16
+#define ARENA_OVERHEAD \
+    (sizeof(block_element_t) + sizeof(size_t) + sizeof(test_arena_t *))
+
+struct test_arena {
+    size_t capacity, used;
+    size_t live; /* Number of blocks carved and not freed yet */
+    bool closed;
+    _Alignas(ARENA_ALIGN) unsigned char area[];
+};
+
 static block_element_t *allocated = NULL;
 static size_t allocated_count = 0;
 
@@ -49,6 +71,8 @@ int fail_probability = 0;
 
 static bool cautious_mode = true;
 static bool noallocate_mode = false;
+static bool intern_mode = false;
+static bool concurrent_mode = false;
 static bool error_occurred = false;
 static char *error_message = "";
 
@@ -59,6 +83,72 @@ static jmp_buf env;
 static volatile sig_atomic_t jmp_ready = false;
 static bool time_limited = false;
 
+/* In concurrent mode, the list of allocated blocks and the intern table are
+ * shared with the reclaimer thread. The lock checks errors so that an
+ * exception can release it without knowing whether it is held.
+ */
+static pthread_mutex_t heap_lock;
+static __thread bool reclaimer_thread = false;
+
+static inline void lock_heap()
+{
+    if (concurrent_mode)
+        pthread_mutex_lock(&heap_lock);
+}
+
+static inline void unlock_heap()
+{
+    if (concurrent_mode)
+        pthread_mutex_unlock(&heap_lock);
+}
+
+/* An exception raised by the time limit in the middle of malloc() or free(),
+ * or while the list of blocks is relinked, would leave them inconsistent if it
+ * jumped out right away. It is held until the heap is updated, or until code
+ * holding it through exception_hold() is done.
+ */
+static __thread volatile sig_atomic_t heap_busy = 0;
+static __thread volatile sig_atomic_t exception_held = false;
+static char *held_message;
+
+static inline void enter_heap()
+{
+    heap_busy++;
+    atomic_signal_fence(memory_order_seq_cst);
+}
+
+static inline void leave_heap()
+{
+    atomic_signal_fence(memory_order_seq_cst);
+    if (!--heap_busy && exception_held) {
+        exception_held = false;
+        trigger_exception(held_message);
+    }
+}
+
+void exception_hold()
+{
+    enter_heap();
+}
+
+void exception_release()
+{
+    leave_heap();
+}
+
+/* Interned strings live in an open-addressing table kept outside of the
+ * blocks, so that the block header does not grow for regular allocations.
+ */
+typedef struct {
+    block_element_t *block;
+    size_t hash;
+    size_t refcnt;
+} intern_entry_t;
+
+static intern_entry_t *intern_table = NULL;
+static size_t intern_buckets = 0;
+static size_t intern_count = 0;
+
 /* For test_malloc and test_calloc */
 typedef enum {
     TEST_MALLOC,
@@ -86,7 +176,7 @@ static block_element_t *find_header(void *p)
 
     block_element_t *b =
         (block_element_t *) ((size_t) p - sizeof(block_element_t));
-    if (cautious_mode) {
+    if (!reclaimer_thread && cautious_mode) {
         /* Make sure this is really an allocated block */
         block_element_t *ab = allocated;
         bool found = false;
@@ -102,7 +192,8 @@ static block_element_t *find_header(void *p)
         }
     }
 
-    if (b->magic_header != MAGICHEADER) {
+    if (b->magic_header != MAGICHEADER && b->magic_header != MAGICINTERN &&
+        b->magic_header != MAGICARENA) {
         report_event(
             MSG_ERROR,
             "Attempted to free unallocated or corrupted block.  Address = %p",
@@ -122,6 +213,96 @@ static size_t *find_footer(block_element_t *b)
     return p;
 }
 
+/* Given pointer to block carved from an arena, find the arena */
+static test_arena_t **find_arena(block_element_t *b)
+{
+    return (test_arena_t **) (find_footer(b) + 1);
+}
+
+/* Add a block to the list of allocated blocks */
+static void add_block(block_element_t *b)
+{
+    lock_heap();
+    b->next = allocated;
+    b->prev = NULL;
+    if (allocated)
+        allocated->prev = b;
+    allocated = b;
+    allocated_count++;
+    unlock_heap();
+}
+
+/* FNV-1a hash of a string */
+static size_t intern_hash(const char *s)
+{
+    uint64_t h = 0xcbf29ce484222325ULL;
+    while (*s) {
+        h ^= (unsigned char) *s++;
+        h *= 0x100000001b3ULL;
+    }
+    return (size_t) h;
+}
+
+/* Find the slot holding string s, or the empty slot where it belongs */
+static intern_entry_t *intern_lookup(const char *s, size_t hash)
+{
+    size_t mask = intern_buckets - 1;
+    size_t i = hash & mask;
+    while (intern_table[i].block &&
+           (intern_table[i].hash != hash ||
+            strcmp((char *) intern_table[i].block->payload, s)))
+        i = (i + 1) & mask;
+    return &intern_table[i];
+}
+
+/* Double the number of slots, keeping the load factor below one half */
+static bool intern_grow()
+{
+    size_t nbuckets = intern_buckets ? intern_buckets << 1 : 64;
+    intern_entry_t *table = calloc(nbuckets, sizeof(intern_entry_t));
+    if (!table)
+        return false;
+
+    for (size_t i = 0; i < intern_buckets; i++) {
+        if (!intern_table[i].block)
+            continue;
+        size_t j = intern_table[i].hash & (nbuckets - 1);
+        while (table[j].block)
+            j = (j + 1) & (nbuckets - 1);
+        table[j] = intern_table[i];
+    }
+    free(intern_table);
+    intern_table = table;
+    intern_buckets = nbuckets;
+    return true;
+}
+
+/* Drop the slot of an interned block, shifting back the rest of its cluster */
+static void intern_remove(intern_entry_t *e)
+{
+    size_t mask = intern_buckets - 1;
+    size_t i = e - intern_table, j = i;
+
+    while (1) {
+        j = (j + 1) & mask;
+        if (!intern_table[j].block)
+            break;
+        size_t k = intern_table[j].hash & mask;
+        /* Move the entry back unless its home slot lies within (i, j] */
+        if (i <= j ? (i < k && k <= j) : (i < k || k <= j))
+            continue;
+        intern_table[i] = intern_table[j];
+        i = j;
+    }
+    intern_table[i].block = NULL;
+
+    if (--intern_count == 0) {
+        free(intern_table);
+        intern_table = NULL;
+        intern_buckets = 0;
+    }
+}
+
 static void *alloc(alloc_t alloc_type, size_t size)
 {
     if (noallocate_mode) {
@@ -142,6 +323,7 @@ static void *alloc(alloc_t alloc_type, size_t size)
         return NULL;
     }
 
+    enter_heap();
     block_element_t *new_block =
         malloc(size + sizeof(block_element_t) + sizeof(size_t));
     if (!new_block) {
@@ -156,15 +338,8 @@ static void *alloc(alloc_t alloc_type, size_t size)
     *find_footer(new_block) = MAGICFOOTER;
     void *p = (void *) &new_block->payload;
     memset(p, !alloc_type * FILLCHAR, size);
-    // cppcheck-suppress nullPointerRedundantCheck
-    new_block->next = allocated;
-    // cppcheck-suppress nullPointerRedundantCheck
-    new_block->prev = NULL;
-
-    if (allocated)
-        allocated->prev = new_block;
-    allocated = new_block;
-    allocated_count++;
+    add_block(new_block);
+    leave_heap();
 
     return p;
 }
@@ -189,7 +364,7 @@ void *test_calloc(size_t nelem, size_t elsize)
 
 void test_free(void *p)
 {
-    if (noallocate_mode) {
+    if (!reclaimer_thread && noallocate_mode) {
         report_event(MSG_FATAL, "Calls to free disallowed");
         return;
     }
@@ -197,6 +372,8 @@ void test_free(void *p)
     if (!p)
         return;
 
+    enter_heap();
+    lock_heap();
     block_element_t *b = find_header(p);
     size_t footer = *find_footer(b);
     if (footer != MAGICFOOTER) {
@@ -206,6 +383,26 @@ void test_free(void *p)
                      p);
         error_occurred = true;
     }
+
+    /* Interned strings are only released along with their last owner */
+    if (b->magic_header == MAGICINTERN) {
+        char *s = (char *) b->payload;
+        intern_entry_t *e = intern_lookup(s, intern_hash(s));
+        if (--e->refcnt) {
+            unlock_heap();
+            leave_heap();
+            return;
+        }
+        intern_remove(e);
+    }
+
+    /* Blocks of an arena are returned along with the whole area */
+    void *area = b;
+    if (b->magic_header == MAGICARENA) {
+        test_arena_t *arena = *find_arena(b);
+        area = !--arena->live && arena->closed ? arena : NULL;
+    }
+
     b->magic_header = MAGICFREE;
     *find_footer(b) = MAGICFREE;
     memset(p, FILLCHAR, b->payload_size);
@@ -219,25 +416,160 @@ void test_free(void *p)
         allocated = bn;
     if (bn)
         bn->prev = bp;
-
-    free(b);
     allocated_count--;
+    unlock_heap();
+
+    free(area);
+    leave_heap();
+}
+
+test_arena_t *test_arena_new(size_t nblocks, size_t bytes)
+{
+    if (noallocate_mode) {
+        report_event(MSG_FATAL, "Calls to malloc are disallowed");
+        return NULL;
+    }
+
+    if (fail_allocation()) {
+        report_event(MSG_WARN, "Malloc returning NULL");
+        return NULL;
+    }
+
+    /* Rounding up each block wastes less than ARENA_ALIGN bytes */
+    size_t slack = ARENA_OVERHEAD + ARENA_ALIGN - 1;
+    if (nblocks > (SIZE_MAX - sizeof(test_arena_t) - bytes) / slack)
+        return NULL;
+
+    enter_heap();
+    size_t capacity = bytes + nblocks * slack;
+    test_arena_t *arena = malloc(sizeof(test_arena_t) + capacity);
+    if (arena) {
+        arena->capacity = capacity;
+        arena->used = 0;
+        arena->live = 0;
+        arena->closed = false;
+    }
+    leave_heap();
+    return arena;
+}
+
+void *test_arena_malloc(test_arena_t *arena, size_t size)
+{
+    if (noallocate_mode) {
+        report_event(MSG_FATAL, "Calls to malloc are disallowed");
+        return NULL;
+    }
+
+    size_t slot = (ARENA_OVERHEAD + size + ARENA_ALIGN - 1) & -ARENA_ALIGN;
+    if (!arena || arena->closed || slot > arena->capacity - arena->used)
+        return NULL;
+
+    enter_heap();
+    block_element_t *new_block =
+        (block_element_t *) (arena->area + arena->used);
+    arena->used += slot;
+    new_block->magic_header = MAGICARENA;
+    new_block->payload_size = size;
+    *find_footer(new_block) = MAGICFOOTER;
+    *find_arena(new_block) = arena;
+    void *p = (void *) &new_block->payload;
+    memset(p, FILLCHAR, size);
+    /* The reclaimer may be freeing other blocks of the arena meanwhile */
+    lock_heap();
+    arena->live++;
+    unlock_heap();
+    add_block(new_block);
+    leave_heap();
+
+    return p;
+}
+
+char *test_arena_strdup(test_arena_t *arena, const char *s)
+{
+    if (intern_mode && !noallocate_mode)
+        return test_strdup(s);
+
+    size_t len = strlen(s) + 1;
+    char *new = test_arena_malloc(arena, len);
+    if (!new)
+        return NULL;
+
+    return memcpy(new, s, len);
+}
+
+void test_arena_close(test_arena_t *arena)
+{
+    if (!arena)
+        return;
+
+    enter_heap();
+    lock_heap();
+    arena->closed = true;
+    bool empty = !arena->live;
+    unlock_heap();
+    if (empty)
+        free(arena);
+    leave_heap();
 }
 
 // cppcheck-suppress unusedFunction
 char *test_strdup(const char *s)
 {
+    if (!intern_mode || noallocate_mode) {
+        size_t len = strlen(s) + 1;
+        void *new = test_malloc(len);
+        if (!new)
+            return NULL;
+
+        return memcpy(new, s, len);
+    }
+
+    size_t hash = intern_hash(s);
+    lock_heap();
+    if (intern_buckets) {
+        intern_entry_t *e = intern_lookup(s, hash);
+        if (e->block) {
+            e->refcnt++;
+            unlock_heap();
+            return (char *) e->block->payload;
+        }
+    }
+    unlock_heap();
+
     size_t len = strlen(s) + 1;
     void *new = test_malloc(len);
     if (!new)
         return NULL;
+    memcpy(new, s, len);
+
+    /* Only the reclaimer runs concurrently, and it never adds strings */
+    enter_heap();
+    lock_heap();
+    /* Fall back to a private copy if the table cannot grow */
+    if (2 * (intern_count + 1) > intern_buckets && !intern_grow()) {
+        unlock_heap();
+        leave_heap();
+        return new;
+    }
 
-    return memcpy(new, s, len);
+    intern_entry_t *e = intern_lookup(s, hash);
+    e->block = (block_element_t *) ((size_t) new - sizeof(block_element_t));
+    e->block->magic_header = MAGICINTERN;
+    e->hash = hash;
+    e->refcnt = 1;
+    intern_count++;
+    unlock_heap();
+    leave_heap();
+
+    return new;
 }
 
 size_t allocation_check()
 {
-    return allocated_count;
+    lock_heap();
+    size_t count = allocated_count;
+    unlock_heap();
+    return count;
 }
 
 /* Implementation of functions for testing */
@@ -258,6 +590,42 @@ void set_noallocate_mode(bool noallocate)
     noallocate_mode = noallocate;
 }
 
+/* Set/unset string interning mode.
+ * In this mode, test_strdup returns a shared, reference-counted copy for
+ * strings that are already allocated.
+ */
+void set_intern_mode(bool intern)
+{
+    intern_mode = intern;
+}
+
+/* Set/unset concurrent mode.
+ * In this mode, the bookkeeping of blocks is protected by a lock, so that a
+ * reclaimer thread can free blocks while the program keeps running.
+ */
+void set_concurrent_mode(bool concurrent)
+{
+    static bool initialized = false;
+    if (concurrent && !initialized) {
+        pthread_mutexattr_t attr;
+        pthread_mutexattr_init(&attr);
+        pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_ERRORCHECK);
+        pthread_mutex_init(&heap_lock, &attr);
+        pthread_mutexattr_destroy(&attr);
+        initialized = true;
+    }
+    concurrent_mode = concurrent;
+}
+
+/* Mark the calling thread as the reclaimer.
+ * Its frees are allowed in restricted allocation mode and skip the lookup of
+ * cautious mode, which would hold the lock for O(allocated) per block.
+ */
+void set_reclaimer_thread()
+{
+    reclaimer_thread = true;
+}
+
 /* Return whether any errors have occurred since last time set error limit */
 bool error_check()
 {
@@ -274,6 +642,10 @@ bool exception_setup(bool limit_time)
     if (sigsetjmp(env, 1)) {
         /* Got here from longjmp */
         jmp_ready = false;
+        /* Release the lock in case the exception interrupted its owner; the
+         * lock rejects the call if this thread does not hold it.
+         */
+        unlock_heap();
         if (time_limited) {
             alarm(0);
             time_limited = false;
@@ -309,6 +681,12 @@ void exception_cancel()
 /* Use longjmp to return to most recent exception setup */
 void trigger_exception(char *msg)
 {
+    if (heap_busy) {
+        held_message = msg;
+        exception_held = true;
+        return;
+    }
+
     error_occurred = true;
     error_message = msg;
     if (jmp_ready)
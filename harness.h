@@ -16,6 +16,29 @@ void test_free(void *p);
 char *test_strdup(const char *s);
 /* FIXME: provide test_realloc as well */
 
+/* Blocks carved back to back from one area, so that blocks allocated in a row
+ * are also adjacent in memory. Each of them is freed on its own by test_free()
+ * and counts as a block of its own, and the area is returned along with the
+ * last one once the arena is closed.
+ */
+typedef struct test_arena test_arena_t;
+
+/* Reserve room for nblocks blocks holding bytes in total, NULL on failure */
+test_arena_t *test_arena_new(size_t nblocks, size_t bytes);
+/* Carve a block, NULL once the reserved room is exhausted */
+void *test_arena_malloc(test_arena_t *arena, size_t size);
+/* Copy a string into a block, shared like test_strdup() when interning */
+char *test_arena_strdup(test_arena_t *arena, const char *s);
+/* Give up carving, releasing the area if no block is left */
+void test_arena_close(test_arena_t *arena);
+
+/* Hold exceptions raised by the time limit until the matching
+ * exception_release(), around code that must not be left halfway.
+ * Holds nest.
+ */
+void exception_hold();
+void exception_release();
+
 #ifdef INTERNAL
 
 /* Report number of allocated blocks */
@@ -36,6 +59,26 @@ void set_cautious_mode(bool cautious);
  */
 void set_noallocate_mode(bool noallocate);
 
+/*
+ * Set/unset string interning mode.
+ * In this mode, test_strdup hands out one reference-counted copy per distinct
+ * string, which test_free only releases along with its last reference.
+ */
+void set_intern_mode(bool intern);
+
+/*
+ * Set/unset concurrent mode.
+ * In this mode, the bookkeeping of blocks is protected by a lock, so that a
+ * reclaimer thread can free blocks while the program keeps running.
+ */
+void set_concurrent_mode(bool concurrent);
+
+/*
+ * Mark the calling thread as the reclaimer. Its frees are allowed in
+ * restricted allocation mode and are not looked up in cautious mode.
+ */
+void set_reclaimer_thread();
+
 /* Return whether any errors have occurred since last time checked */
 bool error_check();
 
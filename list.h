@@ -7,6 +7,7 @@ extern "C" {
 #endif
 
 #include <stddef.h>
+#include <stdint.h>
 
 /**
  * Feature detection for 'typeof':
@@ -64,6 +65,30 @@ struct list_head {
 #endif
 #endif
 
+/**
+ * LIST_PREFETCH_DISTANCE - Number of nodes the prefetching iterators run ahead
+ *
+ * Define it before including this header to tune it for the workload. It must
+ * be at least 1.
+ */
+#ifndef LIST_PREFETCH_DISTANCE
+#define LIST_PREFETCH_DISTANCE 2
+#endif
+
+#if LIST_PREFETCH_DISTANCE < 1
+#error "LIST_PREFETCH_DISTANCE must be at least 1"
+#endif
+
+/**
+ * list_prefetch() - Hint that the memory at @addr is going to be read soon
+ * @addr: address to prefetch, which may be NULL or invalid
+ */
+#if defined(__GNUC__) || defined(__clang__)
+#define list_prefetch(addr) __builtin_prefetch(addr)
+#else
+#define list_prefetch(addr) ((void) (addr))
+#endif
+
 /**
  * LIST_HEAD - Define and initialize a circular list head
  * @head: name of the new list
@@ -462,6 +487,563 @@ static inline void list_move_tail(struct list_head *node,
          ++(entry), ++(safe))
 #endif
 
+/**
+ * list_prefetch_start() - Start the cursor of a prefetching iterator
+ * @node: first node of the iteration
+ * @head: pointer to the head of the list
+ *
+ * Return: the node LIST_PREFETCH_DISTANCE nodes after @node, or @head
+ */
+static inline struct list_head *list_prefetch_start(struct list_head *node,
+                                                    struct list_head *head)
+{
+    for (int i = 0; i < LIST_PREFETCH_DISTANCE && node != head; i++) {
+        node = node->next;
+        list_prefetch(node->next);
+    }
+    return node;
+}
+
+/**
+ * list_prefetch_next() - Advance the cursor of a prefetching iterator
+ * @ahead: the cursor, running LIST_PREFETCH_DISTANCE nodes ahead
+ * @head: pointer to the head of the list
+ *
+ * The node after the new cursor is prefetched, so that advancing the cursor
+ * again does not stall.
+ *
+ * Return: the node after @ahead, or @head once the end is reached
+ */
+static inline struct list_head *list_prefetch_next(struct list_head *ahead,
+                                                   struct list_head *head)
+{
+    if (ahead != head) {
+        ahead = ahead->next;
+        list_prefetch(ahead->next);
+    }
+    return ahead;
+}
+
+/**
+ * list_for_each_prefetch - Iterate over list nodes, prefetching ahead
+ * @node: list_head pointer used as iterator
+ * @ahead: list_head pointer used as the prefetching cursor
+ * @head: pointer to the head of the list
+ *
+ * Same as list_for_each(), while @ahead runs LIST_PREFETCH_DISTANCE nodes in
+ * front of @node and prefetches the nodes it is about to reach.
+ */
+#define list_for_each_prefetch(node, ahead, head)                      \
+    for (node = (head)->next, ahead = list_prefetch_start(node, head); \
+         node != (head);                                               \
+         node = node->next, ahead = list_prefetch_next(ahead, head))
+
+/**
+ * list_for_each_safe_prefetch - Iterate over list nodes, allowing removal and
+ * prefetching ahead
+ * @node: list_head pointer used as iterator
+ * @safe: list_head pointer storing the next node for safe iteration
+ * @ahead: list_head pointer used as the prefetching cursor
+ * @head: pointer to the head of the list
+ *
+ * Same as list_for_each_safe(). Only the current node may be removed, as the
+ * prefetching cursor is always past it.
+ */
+#define list_for_each_safe_prefetch(node, safe, ahead, head)           \
+    for (node = (head)->next, safe = node->next,                       \
+        ahead = list_prefetch_start(node, head);                       \
+         node != (head); node = safe, safe = node->next,               \
+        ahead = list_prefetch_next(ahead, head))
+
+#if __LIST_HAVE_TYPEOF
+/* Prefetch the memory @field points to in the entry at the cursor. The cursor
+ * node has just been read to advance, so reading @field does not stall.
+ */
+#define __list_prefetch_field(ahead, head, type, member, field) \
+    ((ahead) != (head) ? list_prefetch(list_entry(ahead, type, member)->field) \
+                       : (void) 0)
+
+/**
+ * list_for_each_entry_prefetch - Iterate over a list of entries, prefetching
+ * the entries ahead and the memory one of their fields points to
+ * @entry: pointer to the structure type, used as the loop iterator
+ * @ahead: list_head pointer used as the prefetching cursor
+ * @head: pointer to the head of the list
+ * @member: name of the list_head member within the structure type of @entry
+ * @field: name of a pointer member of @entry, such as the string of an
+ *         element, whose target is read for every entry
+ *
+ * Same as list_for_each_entry().
+ */
+#define list_for_each_entry_prefetch(entry, ahead, head, member, field)      \
+    for (entry = list_entry((head)->next, typeof(*entry), member),           \
+        ahead = list_prefetch_start((head)->next, head);                     \
+         &entry->member != (head);                                           \
+         __list_prefetch_field(ahead, head, typeof(*entry), member, field),  \
+        ahead = list_prefetch_next(ahead, head),                             \
+        entry = list_entry(entry->member.next, typeof(*entry), member))
+
+/**
+ * list_for_each_entry_safe_prefetch - Iterate over a list of entries, allowing
+ * removal and prefetching ahead
+ * @entry: pointer to the structure type, used as the loop iterator
+ * @safe: pointer to the structure type, storing the next entry
+ * @ahead: list_head pointer used as the prefetching cursor
+ * @head: pointer to the head of the list
+ * @member: name of the list_head member within the structure type of @entry
+ * @field: name of a pointer member of @entry whose target is prefetched
+ *
+ * Same as list_for_each_entry_safe(). Only the current entry may be removed.
+ */
+#define list_for_each_entry_safe_prefetch(entry, safe, ahead, head, member,  \
+                                          field)                             \
+    for (entry = list_entry((head)->next, typeof(*entry), member),           \
+        safe = list_entry(entry->member.next, typeof(*entry), member),       \
+        ahead = list_prefetch_start((head)->next, head);                     \
+         &entry->member != (head);                                           \
+         __list_prefetch_field(ahead, head, typeof(*entry), member, field),  \
+        ahead = list_prefetch_next(ahead, head), entry = safe,               \
+        safe = list_entry(safe->member.next, typeof(*entry), member))
+#else
+#define list_for_each_entry_prefetch(entry, ahead, head, member, field) \
+    for (entry = (void *) 1; sizeof(struct { int i : -1; }); ++(entry))
+#define list_for_each_entry_safe_prefetch(entry, safe, ahead, head, member, \
+                                          field)                            \
+    for (entry = safe = (void *) 1; sizeof(struct { int i : -1; });         \
+         ++(entry), ++(safe))
+#endif
+
+/**
+ * list_cmp_func_t - Comparator used by list_sort()
+ * @priv: private data passed through list_sort()
+ * @a: first node to compare
+ * @b: second node to compare
+ *
+ * Return: >0 if @a must be sorted after @b, <=0 to keep them in order
+ */
+typedef int (*list_cmp_func_t)(void *priv,
+                               const struct list_head *a,
+                               const struct list_head *b);
+
+/**
+ * LIST_SORT_DEFINE() - Generate a list sort specialized for a comparator
+ * @name: name of the generated function
+ * @cmp: comparator with the signature of list_cmp_func_t, either a function
+ *       or a function-like macro, which is expanded inline
+ *
+ * Defines "static void @name(void *priv, struct list_head *head)", which sorts
+ * the list at @head the same way list_sort() does, without calling @cmp
+ * through a pointer.
+ *
+ * The list is sorted bottom-up: nodes are pushed one at a time onto a stack of
+ * sorted sublists chained through their prev pointers, and two sublists of the
+ * same size 2^k are merged as soon as a third one follows them, which keeps
+ * merges balanced at 2:1 and the working set small. Only the final merge
+ * rebuilds the prev pointers.
+ */
+#define LIST_SORT_DEFINE(name, cmp) \
+    LIST_SORT_DEFINE_COUNTED(name, cmp, __list_sort_uncounted)
+
+#define __list_sort_uncounted(event) ((void) 0)
+
+/**
+ * LIST_SORT_DEFINE_COUNTED() - Generate an instrumented list sort
+ * @name: name of the generated function
+ * @cmp: comparator, as for LIST_SORT_DEFINE()
+ * @count: function-like macro, expanded as @count(hops) for every node a merge
+ *         links and as @count(merges) for every merge of two sublists
+ *
+ * Same as LIST_SORT_DEFINE(), which passes a @count expanding to nothing.
+ */
+#define LIST_SORT_DEFINE_COUNTED(name, cmp, count)                             \
+    static inline struct list_head *name##_merge(                              \
+        void *priv, struct list_head *a, struct list_head *b)                  \
+    {                                                                          \
+        struct list_head *head = NULL, **tail = &head;                         \
+        count(merges);                                                         \
+        for (;;) {                                                             \
+            count(hops);                                                       \
+            if (cmp(priv, a, b) <= 0) {                                        \
+                *tail = a;                                                     \
+                tail = &a->next;                                               \
+                a = a->next;                                                   \
+                if (!a) {                                                      \
+                    *tail = b;                                                 \
+                    break;                                                     \
+                }                                                              \
+            } else {                                                           \
+                *tail = b;                                                     \
+                tail = &b->next;                                               \
+                b = b->next;                                                   \
+                if (!b) {                                                      \
+                    *tail = a;                                                 \
+                    break;                                                     \
+                }                                                              \
+            }                                                                  \
+        }                                                                      \
+        return head;                                                           \
+    }                                                                          \
+                                                                               \
+    static inline void name##_merge_final(void *priv, struct list_head *head,  \
+                                          struct list_head *a,                 \
+                                          struct list_head *b)                 \
+    {                                                                          \
+        struct list_head *tail = head;                                         \
+        count(merges);                                                         \
+        for (;;) {                                                             \
+            count(hops);                                                       \
+            if (cmp(priv, a, b) <= 0) {                                        \
+                tail->next = a;                                                \
+                a->prev = tail;                                                \
+                tail = a;                                                      \
+                a = a->next;                                                   \
+                if (!a)                                                        \
+                    break;                                                     \
+            } else {                                                           \
+                tail->next = b;                                                \
+                b->prev = tail;                                                \
+                tail = b;                                                      \
+                b = b->next;                                                   \
+                if (!b) {                                                      \
+                    b = a;                                                     \
+                    break;                                                     \
+                }                                                              \
+            }                                                                  \
+        }                                                                      \
+        do {                                                                   \
+            count(hops);                                                       \
+            tail->next = b;                                                    \
+            b->prev = tail;                                                    \
+            tail = b;                                                          \
+            b = b->next;                                                       \
+        } while (b);                                                           \
+        tail->next = head;                                                     \
+        head->prev = tail;                                                     \
+    }                                                                          \
+                                                                               \
+    static inline __attribute__((unused)) void name(void *priv,                \
+                                                    struct list_head *head)    \
+    {                                                                          \
+        struct list_head *list = head->next, *pending = NULL;                  \
+        size_t count = 0;                                                      \
+                                                                               \
+        if (list == head->prev)                                                \
+            return;                                                            \
+        head->prev->next = NULL;                                               \
+                                                                               \
+        do {                                                                   \
+            size_t bits;                                                       \
+            struct list_head **tail = &pending;                                \
+            for (bits = count; bits & 1; bits >>= 1)                           \
+                tail = &(*tail)->prev;                                         \
+            if (bits) {                                                        \
+                struct list_head *a = *tail, *b = a->prev;                     \
+                a = name##_merge(priv, b, a);                                  \
+                a->prev = b->prev;                                             \
+                *tail = a;                                                     \
+            }                                                                  \
+            list->prev = pending;                                              \
+            pending = list;                                                    \
+            list = list->next;                                                 \
+            pending->next = NULL;                                              \
+            count++;                                                           \
+        } while (list);                                                        \
+                                                                               \
+        list = pending;                                                        \
+        pending = pending->prev;                                               \
+        for (;;) {                                                             \
+            struct list_head *next = pending->prev;                            \
+            if (!next)                                                         \
+                break;                                                         \
+            list = name##_merge(priv, pending, list);                          \
+            pending = next;                                                    \
+        }                                                                      \
+        name##_merge_final(priv, head, pending, list);                         \
+    }
+
+/* Context of list_sort(), calling the comparator through a pointer */
+struct __list_sort_ctx {
+    list_cmp_func_t cmp;
+    void *priv;
+};
+
+#define __list_sort_call(ctx, a, b) \
+    ((struct __list_sort_ctx *) (ctx))->cmp(                                \
+        ((struct __list_sort_ctx *) (ctx))->priv, a, b)
+
+LIST_SORT_DEFINE(__list_sort, __list_sort_call)
+
+/**
+ * list_sort() - Sort a list
+ * @priv: private data, passed unchanged to @cmp
+ * @head: pointer to the head of the list
+ * @cmp: comparator deciding the order of two nodes
+ *
+ * The sort is stable: nodes comparing equal keep their relative order. It
+ * allocates nothing and uses constant stack space. Hot callers can avoid the
+ * indirect call to @cmp by defining their own sort with LIST_SORT_DEFINE().
+ */
+static inline void list_sort(void *priv,
+                             struct list_head *head,
+                             list_cmp_func_t cmp)
+{
+    struct __list_sort_ctx ctx = {cmp, priv};
+    __list_sort(&ctx, head);
+}
+
+/**
+ * struct slist_node - Node of a singly-linked tail queue
+ * @next: Pointer to the next node, NULL for the last node
+ */
+struct slist_node {
+    struct slist_node *next;
+};
+
+/**
+ * struct stailq_head - Head of a singly-linked tail queue
+ * @first: Pointer to the first node, NULL for an empty queue
+ * @last: Pointer to the next pointer of the last node, or to @first for an
+ *        empty queue
+ *
+ * Nodes carry a single pointer, half the size of a list_head. Nodes can be
+ * added at both ends and removed from the front in O(1), which is all a FIFO
+ * needs, but there is no way back from a node.
+ */
+struct stailq_head {
+    struct slist_node *first;
+    struct slist_node **last;
+};
+
+/**
+ * INIT_STAILQ_HEAD() - Initialize an empty tail queue
+ * @head: pointer to the head of the tail queue
+ */
+static inline void INIT_STAILQ_HEAD(struct stailq_head *head)
+{
+    head->first = NULL;
+    head->last = &head->first;
+}
+
+/**
+ * stailq_empty() - Check if the tail queue has no nodes attached
+ * @head: pointer to the head of the tail queue
+ *
+ * Return: 0 - tail queue is not empty !0 - tail queue is empty
+ */
+static inline int stailq_empty(const struct stailq_head *head)
+{
+    return !head->first;
+}
+
+/**
+ * stailq_add() - Add a node to the beginning of the tail queue
+ * @node: pointer to the new node
+ * @head: pointer to the head of the tail queue
+ */
+static inline void stailq_add(struct slist_node *node, struct stailq_head *head)
+{
+    node->next = head->first;
+    if (!node->next)
+        head->last = &node->next;
+    head->first = node;
+}
+
+/**
+ * stailq_add_tail() - Add a node to the end of the tail queue
+ * @node: pointer to the new node
+ * @head: pointer to the head of the tail queue
+ */
+static inline void stailq_add_tail(struct slist_node *node,
+                                   struct stailq_head *head)
+{
+    node->next = NULL;
+    *head->last = node;
+    head->last = &node->next;
+}
+
+/**
+ * stailq_del_head() - Remove the first node of the tail queue
+ * @head: pointer to the head of the tail queue
+ *
+ * Return: the removed node, NULL if the tail queue is empty
+ */
+static inline struct slist_node *stailq_del_head(struct stailq_head *head)
+{
+    struct slist_node *node = head->first;
+    if (node) {
+        head->first = node->next;
+        if (!head->first)
+            head->last = &head->first;
+    }
+    return node;
+}
+
+/**
+ * stailq_for_each - Iterate over tail queue nodes
+ * @node: slist_node pointer used as iterator
+ * @head: pointer to the head of the tail queue
+ *
+ * The nodes and the head must be kept unmodified while iterating.
+ */
+#define stailq_for_each(node, head) \
+    for (node = (head)->first; node; node = node->next)
+
+/**
+ * struct xlist_node - Node of an XOR-linked list
+ * @link: Addresses of the previous and the next node XORed together, where a
+ *        missing neighbour counts as NULL
+ *
+ * A node is as small as a singly-linked one, yet the list can be walked and
+ * modified from both ends. Walking needs the node it came from, so there is
+ * no way to unlink a node given only its address.
+ */
+struct xlist_node {
+    uintptr_t link;
+};
+
+/**
+ * struct xlist_head - Head of an XOR-linked list
+ * @first: Pointer to the first node, NULL for an empty list
+ * @last: Pointer to the last node, NULL for an empty list
+ */
+struct xlist_head {
+    struct xlist_node *first, *last;
+};
+
+/**
+ * INIT_XLIST_HEAD() - Initialize an empty XOR-linked list
+ * @head: pointer to the head of the list
+ */
+static inline void INIT_XLIST_HEAD(struct xlist_head *head)
+{
+    head->first = head->last = NULL;
+}
+
+/**
+ * xlist_empty() - Check if the XOR-linked list has no nodes attached
+ * @head: pointer to the head of the list
+ *
+ * Return: 0 - list is not empty !0 - list is empty
+ */
+static inline int xlist_empty(const struct xlist_head *head)
+{
+    return !head->first;
+}
+
+/* Link @node beyond @end, which points to the first or the last node of a
+ * list, and make it the new end. @other is the opposite end.
+ */
+static inline void __xlist_add_end(struct xlist_node *node,
+                                   struct xlist_node **end,
+                                   struct xlist_node **other)
+{
+    node->link = (uintptr_t) *end;
+    if (*end)
+        (*end)->link ^= (uintptr_t) node;
+    else
+        *other = node;
+    *end = node;
+}
+
+/* Unlink the node at @end, the first or the last node of a non-empty list */
+static inline struct xlist_node *__xlist_del_end(struct xlist_node **end,
+                                                 struct xlist_node **other)
+{
+    struct xlist_node *node = *end;
+    struct xlist_node *next = (struct xlist_node *) node->link;
+    if (next)
+        next->link ^= (uintptr_t) node;
+    else
+        *other = NULL;
+    *end = next;
+    return node;
+}
+
+/**
+ * xlist_add() - Add a node to the beginning of the XOR-linked list
+ * @node: pointer to the new node
+ * @head: pointer to the head of the list
+ */
+static inline void xlist_add(struct xlist_node *node, struct xlist_head *head)
+{
+    __xlist_add_end(node, &head->first, &head->last);
+}
+
+/**
+ * xlist_add_tail() - Add a node to the end of the XOR-linked list
+ * @node: pointer to the new node
+ * @head: pointer to the head of the list
+ */
+static inline void xlist_add_tail(struct xlist_node *node,
+                                  struct xlist_head *head)
+{
+    __xlist_add_end(node, &head->last, &head->first);
+}
+
+/**
+ * xlist_del_head() - Remove the first node of the XOR-linked list
+ * @head: pointer to the head of the list
+ *
+ * Return: the removed node, NULL if the list is empty
+ */
+static inline struct xlist_node *xlist_del_head(struct xlist_head *head)
+{
+    return head->first ? __xlist_del_end(&head->first, &head->last) : NULL;
+}
+
+/**
+ * xlist_del_tail() - Remove the last node of the XOR-linked list
+ * @head: pointer to the head of the list
+ *
+ * Return: the removed node, NULL if the list is empty
+ */
+static inline struct xlist_node *xlist_del_tail(struct xlist_head *head)
+{
+    return head->last ? __xlist_del_end(&head->last, &head->first) : NULL;
+}
+
+/**
+ * xlist_reverse() - Reverse the XOR-linked list in O(1)
+ * @head: pointer to the head of the list
+ *
+ * Every link reads the same in both directions, so only the ends are swapped.
+ */
+static inline void xlist_reverse(struct xlist_head *head)
+{
+    struct xlist_node *first = head->first;
+    head->first = head->last;
+    head->last = first;
+}
+
+/**
+ * xlist_step() - Move to the next node of an XOR-linked list
+ * @prev: pointer to the node iterated before @node, NULL at the first node.
+ *        Updated to @node.
+ * @node: the current node
+ *
+ * Return: the node after @node, NULL once the end is reached
+ */
+static inline struct xlist_node *xlist_step(struct xlist_node **prev,
+                                            struct xlist_node *node)
+{
+    struct xlist_node *next =
+        (struct xlist_node *) (node->link ^ (uintptr_t) *prev);
+    *prev = node;
+    return next;
+}
+
+/**
+ * xlist_for_each - Iterate over XOR-linked list nodes from the first one
+ * @node: xlist_node pointer used as iterator
+ * @prev: xlist_node pointer holding the previously iterated node
+ * @head: pointer to the head of the list
+ *
+ * The nodes and the head must be kept unmodified while iterating.
+ */
+#define xlist_for_each(node, prev, head)          \
+    for (prev = NULL, node = (head)->first; node; \
+         node = xlist_step(&prev, node))
+
 #undef __LIST_HAVE_TYPEOF
 
 #ifdef __cplusplus
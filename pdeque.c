@@ -0,0 +1,276 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "pdeque.h"
+
+#define pd_entry(h) container_of(h, pdeque_t, head)
+
+/* Allocate a node holding a copy of @s in front of @next.
+ * The reference held by the caller on @next is handed over to the new node.
+ */
+static pd_node_t *pd_node_new(const char *s, pd_node_t *next)
+{
+    pd_node_t *node = malloc(sizeof(pd_node_t));
+    if (!node)
+        return NULL;
+
+    node->value = strdup(s);
+    if (!node->value) {
+        free(node);
+        return NULL;
+    }
+    node->next = next;
+    node->refcnt = 1;
+    return node;
+}
+
+static inline pd_node_t *pd_retain(pd_node_t *node)
+{
+    if (node)
+        node->refcnt++;
+    return node;
+}
+
+/* Drop one reference, releasing every node that is no longer shared */
+static void pd_release(pd_node_t *node)
+{
+    while (node && --node->refcnt == 0) {
+        pd_node_t *next = node->next;
+        test_free(node->value);
+        test_free(node);
+        node = next;
+    }
+}
+
+/* Copy the older half of a list, in reverse order, into the empty list @to.
+ * The newer half stays in @from: cut off in place when no other version
+ * shares its nodes, copied otherwise, so no list holds nodes past its count.
+ */
+static bool pd_split(pd_node_t **from,
+                     size_t *nfrom,
+                     pd_node_t **to,
+                     size_t *nto)
+{
+    size_t keep = *nfrom / 2, move = *nfrom - keep;
+    pd_node_t *node = *from, *last = NULL, *list = NULL;
+    bool shared = false;
+
+    for (size_t i = 0; i < keep; i++, node = node->next) {
+        shared |= node->refcnt > 1;
+        last = node;
+    }
+    for (size_t i = 0; i < move; i++, node = node->next) {
+        pd_node_t *copy = pd_node_new(node->value, list);
+        if (!copy) {
+            pd_release(list);
+            return false;
+        }
+        list = copy;
+    }
+
+    if (shared || !keep) {
+        pd_node_t *kept = NULL, **link = &kept;
+        node = *from;
+        for (size_t i = 0; i < keep; i++, node = node->next) {
+            pd_node_t *copy = pd_node_new(node->value, NULL);
+            if (!copy) {
+                pd_release(kept);
+                pd_release(list);
+                return false;
+            }
+            *link = copy;
+            link = &copy->next;
+        }
+        pd_release(*from);
+        *from = kept;
+    } else {
+        pd_release(last->next);
+        last->next = NULL;
+    }
+
+    *to = list;
+    *nto = move;
+    *nfrom = keep;
+    return true;
+}
+
+/* Remove the first node of a non-empty list */
+static void pd_pop(pd_node_t **list, size_t *count, char *sp, size_t bufsize)
+{
+    pd_node_t *node = *list;
+
+    if (sp && bufsize > 0) {
+        strncpy(sp, node->value, bufsize - 1);
+        sp[bufsize - 1] = '\0';
+    }
+
+    *list = --*count ? pd_retain(node->next) : NULL;
+    pd_release(node);
+}
+
+/* Create an empty deque */
+struct list_head *pd_new()
+{
+    pdeque_t *d = malloc(sizeof(pdeque_t));
+    if (!d)
+        return NULL;
+
+    INIT_LIST_HEAD(&d->head);
+    d->front = d->rear = NULL;
+    d->nfront = d->nrear = 0;
+    return &d->head;
+}
+
+/* Release a version of the deque */
+void pd_free(struct list_head *head)
+{
+    if (!head)
+        return;
+
+    pdeque_t *d = pd_entry(head);
+    pd_release(d->front);
+    pd_release(d->rear);
+    free(d);
+}
+
+/* Take a snapshot sharing every node */
+struct list_head *pd_snapshot(struct list_head *head)
+{
+    if (!head)
+        return NULL;
+
+    struct list_head *snap = pd_new();
+    if (snap)
+        pd_restore(snap, head);
+    return snap;
+}
+
+/* Replace the content of the deque with a snapshot */
+void pd_restore(struct list_head *head, struct list_head *snap)
+{
+    if (!head || !snap || head == snap)
+        return;
+
+    pdeque_t *d = pd_entry(head);
+    const pdeque_t *s = pd_entry(snap);
+
+    /* Retain first, the old nodes may be shared with the snapshot */
+    pd_retain(s->front);
+    pd_retain(s->rear);
+    pd_release(d->front);
+    pd_release(d->rear);
+    d->front = s->front;
+    d->rear = s->rear;
+    d->nfront = s->nfront;
+    d->nrear = s->nrear;
+}
+
+/* Insert an element at head of the deque */
+bool pd_insert_head(struct list_head *head, const char *s)
+{
+    if (!head || !s)
+        return false;
+
+    pdeque_t *d = pd_entry(head);
+    pd_node_t *node = pd_node_new(s, d->front);
+    if (!node)
+        return false;
+    d->front = node;
+    d->nfront++;
+    return true;
+}
+
+/* Insert an element at tail of the deque */
+bool pd_insert_tail(struct list_head *head, const char *s)
+{
+    if (!head || !s)
+        return false;
+
+    pdeque_t *d = pd_entry(head);
+    pd_node_t *node = pd_node_new(s, d->rear);
+    if (!node)
+        return false;
+    d->rear = node;
+    d->nrear++;
+    return true;
+}
+
+/* Remove an element from head of the deque */
+bool pd_remove_head(struct list_head *head, char *sp, size_t bufsize)
+{
+    if (!head)
+        return false;
+
+    pdeque_t *d = pd_entry(head);
+    if (!d->nfront &&
+        (!d->nrear || !pd_split(&d->rear, &d->nrear, &d->front, &d->nfront)))
+        return false;
+
+    pd_pop(&d->front, &d->nfront, sp, bufsize);
+    return true;
+}
+
+/* Remove an element from tail of the deque */
+bool pd_remove_tail(struct list_head *head, char *sp, size_t bufsize)
+{
+    if (!head)
+        return false;
+
+    pdeque_t *d = pd_entry(head);
+    if (!d->nrear &&
+        (!d->nfront || !pd_split(&d->front, &d->nfront, &d->rear, &d->nrear)))
+        return false;
+
+    pd_pop(&d->rear, &d->nrear, sp, bufsize);
+    return true;
+}
+
+/* Return number of elements in the deque */
+size_t pd_size(struct list_head *head)
+{
+    if (!head)
+        return 0;
+
+    const pdeque_t *d = pd_entry(head);
+    return d->nfront + d->nrear;
+}
+
+/* Reverse elements by swapping the two lists */
+void pd_reverse(struct list_head *head)
+{
+    if (!head)
+        return;
+
+    pdeque_t *d = pd_entry(head);
+    pd_node_t *list = d->front;
+    size_t count = d->nfront;
+    d->front = d->rear;
+    d->nfront = d->nrear;
+    d->rear = list;
+    d->nrear = count;
+}
+
+/* Get the first elements of the deque */
+size_t pd_peek(struct list_head *head, const char **out, size_t n)
+{
+    if (!head)
+        return 0;
+
+    const pdeque_t *d = pd_entry(head);
+    size_t got = 0;
+
+    const pd_node_t *node = d->front;
+    for (; got < n && got < d->nfront; got++, node = node->next)
+        out[got] = node->value;
+
+    /* The rear list holds the remaining elements last first */
+    size_t m = n - got < d->nrear ? n - got : d->nrear;
+    node = d->rear;
+    for (size_t i = 0; i < d->nrear - m; i++)
+        node = node->next;
+    for (size_t i = 0; i < m; i++, node = node->next)
+        out[got + m - 1 - i] = node->value;
+
+    return got + m;
+}
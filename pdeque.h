@@ -0,0 +1,151 @@
+#ifndef LAB0_PDEQUE_H
+#define LAB0_PDEQUE_H
+
+/* This program implements a persistent double-ended queue of strings.
+ *
+ * It is a banker's deque: a front list holding elements from the head and a
+ * rear list holding elements from the tail in reverse order. Both lists are
+ * immutable singly-linked lists of reference-counted nodes, so a snapshot
+ * shares every node with the queue it was taken from and later operations
+ * only allocate the nodes they touch.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "harness.h"
+#include "list.h"
+
+/**
+ * pd_node_t - Immutable node of a persistent list
+ * @next: the following node, shared by every list reaching this node
+ * @refcnt: number of deques and nodes referring to this node
+ * @value: pointer to array holding string, released along with the node
+ */
+typedef struct pd_node {
+    struct pd_node *next;
+    size_t refcnt;
+    char *value;
+} pd_node_t;
+
+/**
+ * pdeque_t - Version of a persistent deque
+ * @head: list head used as the handle of this version, so that it can be kept
+ *        wherever a queue head is expected. It is never linked and always
+ *        looks like an empty list.
+ * @front: elements from the head of the queue, first element first
+ * @rear: elements from the tail of the queue, last element first
+ * @nfront: number of elements taken from @front
+ * @nrear: number of elements taken from @rear
+ *
+ * A list may continue past its count when its nodes are shared with another
+ * version; the nodes beyond the count do not belong to this version.
+ */
+typedef struct {
+    struct list_head head;
+    pd_node_t *front, *rear;
+    size_t nfront, nrear;
+} pdeque_t;
+
+/* Operations on persistent deque */
+
+/**
+ * pd_new() - Create an empty persistent deque
+ *
+ * Return: the handle of the deque, NULL for allocation failed
+ */
+struct list_head *pd_new();
+
+/**
+ * pd_free() - Release a version of the deque, no effect if @head is NULL
+ * @head: handle of the deque
+ *
+ * Nodes shared with other versions stay alive until their last user is
+ * released.
+ */
+void pd_free(struct list_head *head);
+
+/**
+ * pd_snapshot() - Take a point-in-time copy of the deque in O(1)
+ * @head: handle of the deque
+ *
+ * The snapshot shares all nodes with @head and is unaffected by later
+ * operations on either of them.
+ *
+ * Return: handle of the snapshot, NULL for allocation failed or @head is NULL
+ */
+struct list_head *pd_snapshot(struct list_head *head);
+
+/**
+ * pd_restore() - Replace the content of the deque with a snapshot in O(1)
+ * @head: handle of the deque
+ * @snap: handle of the snapshot, which remains valid
+ */
+void pd_restore(struct list_head *head, struct list_head *snap);
+
+/**
+ * pd_insert_head() - Insert an element at the head
+ * @head: handle of the deque
+ * @s: string would be inserted
+ *
+ * Return: true for success, false for allocation failed or @head is NULL
+ */
+bool pd_insert_head(struct list_head *head, const char *s);
+
+/**
+ * pd_insert_tail() - Insert an element at the tail
+ * @head: handle of the deque
+ * @s: string would be inserted
+ *
+ * Return: true for success, false for allocation failed or @head is NULL
+ */
+bool pd_insert_tail(struct list_head *head, const char *s);
+
+/**
+ * pd_remove_head() - Remove the element from head of the deque
+ * @head: handle of the deque
+ * @sp: output buffer where the removed string is copied
+ * @bufsize: size of the string
+ *
+ * When the front list is exhausted, the older half of the rear list is copied
+ * into a new front list.
+ *
+ * Return: true for success, false for allocation failed or deque is empty.
+ */
+bool pd_remove_head(struct list_head *head, char *sp, size_t bufsize);
+
+/**
+ * pd_remove_tail() - Remove the element from tail of the deque
+ * @head: handle of the deque
+ * @sp: output buffer where the removed string is copied
+ * @bufsize: size of the string
+ *
+ * Return: true for success, false for allocation failed or deque is empty.
+ */
+bool pd_remove_tail(struct list_head *head, char *sp, size_t bufsize);
+
+/**
+ * pd_size() - Get the number of elements in the deque
+ * @head: handle of the deque
+ *
+ * Return: the number of elements, zero if deque is NULL or empty
+ */
+size_t pd_size(struct list_head *head);
+
+/**
+ * pd_reverse() - Reverse elements in the deque in O(1)
+ * @head: handle of the deque
+ */
+void pd_reverse(struct list_head *head);
+
+/**
+ * pd_peek() - Get the first elements of the deque
+ * @head: handle of the deque
+ * @out: array receiving pointers to the strings, from the head onward
+ * @n: capacity of @out
+ *
+ * Return: the number of strings stored in @out
+ */
+size_t pd_peek(struct list_head *head, const char **out, size_t n);
+
+#endif /* LAB0_PDEQUE_H */
@@ -0,0 +1,178 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "pqueue.h"
+
+#define pq_entry(n) container_of(n, pq_element_t, node)
+
+/* Whether @a should stay closer to the root than @b */
+static inline bool pq_before(const pq_node_t *a,
+                             const pq_node_t *b,
+                             bool descend)
+{
+    int cmp = strcmp(pq_entry(a)->value, pq_entry(b)->value);
+    return descend ? cmp >= 0 : cmp <= 0;
+}
+
+/* Link two heaps, the losing root becomes the leftmost child of the winner */
+static pq_node_t *pq_meld(pq_node_t *a, pq_node_t *b, bool descend)
+{
+    if (!a)
+        return b;
+    if (!b)
+        return a;
+
+    if (!pq_before(a, b, descend)) {
+        pq_node_t *tmp = a;
+        a = b;
+        b = tmp;
+    }
+    b->sibling = a->child;
+    a->child = b;
+    return a;
+}
+
+/* Two-pass pairing of a sibling list into a single heap.
+ * Both passes are iterative so that a root with a million children does not
+ * exhaust the stack.
+ */
+static pq_node_t *pq_merge_pairs(pq_node_t *first, bool descend)
+{
+    pq_node_t *pairs = NULL;
+
+    /* Left to right: meld adjacent pairs, stacking the results in reverse */
+    while (first) {
+        pq_node_t *a = first, *b = a->sibling;
+        if (!b) {
+            a->sibling = pairs;
+            pairs = a;
+            break;
+        }
+        first = b->sibling;
+        a->sibling = b->sibling = NULL;
+        a = pq_meld(a, b, descend);
+        a->sibling = pairs;
+        pairs = a;
+    }
+
+    /* Right to left: accumulate the stacked pairs into one heap */
+    pq_node_t *root = NULL;
+    while (pairs) {
+        pq_node_t *next = pairs->sibling;
+        pairs->sibling = NULL;
+        root = pq_meld(root, pairs, descend);
+        pairs = next;
+    }
+    return root;
+}
+
+/* Detach every node of the heap into a single sibling list */
+static pq_node_t *pq_flatten(pq_node_t *root)
+{
+    pq_node_t *flat = NULL;
+
+    while (root) {
+        pq_node_t *node = root;
+        root = node->sibling;
+        if (node->child) {
+            pq_node_t *last = node->child;
+            while (last->sibling)
+                last = last->sibling;
+            last->sibling = root;
+            root = node->child;
+        }
+        node->child = NULL;
+        node->sibling = flat;
+        flat = node;
+    }
+    return flat;
+}
+
+/* Create an empty priority queue */
+pqueue_t *pq_new(bool descend)
+{
+    pqueue_t *pq = malloc(sizeof(pqueue_t));
+    if (pq) {
+        pq->root = NULL;
+        pq->size = 0;
+        pq->descend = descend;
+    }
+    return pq;
+}
+
+/* Free all storage used by priority queue */
+void pq_free(pqueue_t *pq)
+{
+    if (!pq)
+        return;
+
+    pq_node_t *node = pq_flatten(pq->root);
+    while (node) {
+        pq_node_t *next = node->sibling;
+        pq_release_element(pq_entry(node));
+        node = next;
+    }
+    free(pq);
+}
+
+/* Insert an element into priority queue */
+bool pq_push(pqueue_t *pq, const char *s)
+{
+    if (!pq || !s)
+        return false;
+
+    pq_element_t *new_element = malloc(sizeof(pq_element_t));
+    if (!new_element)
+        return false;
+
+    new_element->value = strdup(s);
+    if (!new_element->value) {
+        free(new_element);
+        return false;
+    }
+
+    new_element->node.child = new_element->node.sibling = NULL;
+    pq->root = pq_meld(pq->root, &new_element->node, pq->descend);
+    pq->size++;
+
+    return true;
+}
+
+/* Remove the element with the highest priority */
+pq_element_t *pq_pop(pqueue_t *pq, char *sp, size_t bufsize)
+{
+    if (!pq || !pq->root)
+        return NULL;
+
+    pq_node_t *top = pq->root;
+    pq->root = pq_merge_pairs(top->child, pq->descend);
+    pq->size--;
+    top->child = NULL;
+
+    pq_element_t *element = pq_entry(top);
+    if (sp && bufsize > 0) {
+        strncpy(sp, element->value, bufsize - 1);
+        sp[bufsize - 1] = '\0';
+    }
+
+    return element;
+}
+
+/* Get the string with the highest priority */
+const char *pq_peek(const pqueue_t *pq)
+{
+    if (!pq || !pq->root)
+        return NULL;
+    return pq_entry(pq->root)->value;
+}
+
+/* Rebuild the heap for a different ordering */
+void pq_set_order(pqueue_t *pq, bool descend)
+{
+    if (!pq || pq->descend == descend)
+        return;
+
+    pq->descend = descend;
+    pq->root = pq_merge_pairs(pq_flatten(pq->root), descend);
+}
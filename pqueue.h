@@ -0,0 +1,121 @@
+#ifndef LAB0_PQUEUE_H
+#define LAB0_PQUEUE_H
+
+/* This program implements a priority queue of strings.
+ *
+ * It uses a pairing heap built from intrusive nodes, so insertion is O(1) and
+ * extracting the minimum (or maximum) element is O(log n) amortized.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "harness.h"
+#include "list.h"
+
+/**
+ * pq_node_t - Node of a pairing heap
+ * @child: leftmost child of this node
+ * @sibling: next sibling to the right of this node
+ */
+typedef struct pq_node {
+    struct pq_node *child;
+    struct pq_node *sibling;
+} pq_node_t;
+
+/**
+ * pq_element_t - Priority queue element
+ * @value: pointer to array holding string
+ * @node: node of the pairing heap
+ *
+ * @value needs to be explicitly allocated and freed
+ */
+typedef struct {
+    char *value;
+    pq_node_t node;
+} pq_element_t;
+
+/**
+ * pqueue_t - Priority queue
+ * @root: the element with the highest priority, NULL if the heap is empty
+ * @size: the number of elements in the heap
+ * @descend: whether the largest string has the highest priority
+ */
+typedef struct {
+    pq_node_t *root;
+    int size;
+    bool descend;
+} pqueue_t;
+
+/* Operations on priority queue */
+
+/**
+ * pq_new() - Create an empty priority queue
+ * @descend: whether pq_pop() extracts the largest string instead of the
+ * smallest one
+ *
+ * Return: NULL for allocation failed
+ */
+pqueue_t *pq_new(bool descend);
+
+/**
+ * pq_free() - Free all storage used by priority queue, no effect if @pq is
+ * NULL
+ * @pq: the priority queue
+ */
+void pq_free(pqueue_t *pq);
+
+/**
+ * pq_push() - Insert an element into the priority queue
+ * @pq: the priority queue
+ * @s: string would be inserted
+ *
+ * Argument s points to the string to be stored.
+ * The function must explicitly allocate space and copy the string into it.
+ *
+ * Return: true for success, false for allocation failed or @pq is NULL
+ */
+bool pq_push(pqueue_t *pq, const char *s);
+
+/**
+ * pq_pop() - Remove the element with the highest priority
+ * @pq: the priority queue
+ * @sp: output buffer where the removed string is copied
+ * @bufsize: size of the string
+ *
+ * If sp is non-NULL and an element is removed, copy the removed string to *sp
+ * (up to a maximum of bufsize-1 characters, plus a null terminator.)
+ * As with q_remove_head(), the element is unlinked but not freed.
+ *
+ * Return: the pointer to element, %NULL if @pq is NULL or empty.
+ */
+pq_element_t *pq_pop(pqueue_t *pq, char *sp, size_t bufsize);
+
+/**
+ * pq_peek() - Get the string with the highest priority without removing it
+ * @pq: the priority queue
+ *
+ * Return: the string, %NULL if @pq is NULL or empty.
+ */
+const char *pq_peek(const pqueue_t *pq);
+
+/**
+ * pq_set_order() - Change the ordering of the priority queue
+ * @pq: the priority queue
+ * @descend: whether the largest string has the highest priority
+ *
+ * The heap is rebuilt in O(n) if the ordering actually changes.
+ */
+void pq_set_order(pqueue_t *pq, bool descend);
+
+/**
+ * pq_release_element() - Release the element
+ * @e: element would be released
+ */
+static inline void pq_release_element(pq_element_t *e)
+{
+    test_free(e->value);
+    test_free(e);
+}
+
+#endif /* LAB0_PQUEUE_H */
@@ -3,6 +3,9 @@
 #include <assert.h>
 #include <errno.h>
 #include <getopt.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <math.h>
 #include <signal.h>
 #include <spawn.h>
 #include <stdio.h>
@@ -44,8 +47,18 @@ extern int show_entropy;
  */
 #include "queue.h"
 
+#include "aqueue.h"
+#include "backend.h"
 #include "console.h"
+#include "extsort.h"
+#include "pdeque.h"
+#include "pqueue.h"
+#include "reclaim.h"
+#include "rlequeue.h"
 #include "report.h"
+#include "stats.h"
+#include "tqueue.h"
+#include "varint.h"
 
 /* Settable parameters */
 
@@ -67,6 +80,9 @@ typedef struct {
 static queue_chain_t chain = {.size = 0};
 static queue_contex_t *current = NULL;
 
+/* Priority queue, allocated on first push and released once drained */
+static pqueue_t *pq = NULL;
+
 /* How many times can queue operations fail */
 static int fail_limit = BIG_LIST_SIZE;
 static int fail_count = 0;
@@ -75,6 +91,47 @@ static int string_length = MAXSTRING;
 
 static int descend = 0;
 
+/* Whether identical strings share one reference-counted copy */
+static int intern = 0;
+
+/* Kilobytes of strings in each run sort sorts on its own, see extsort.h */
+static int sortmem = 0;
+
+/* Whether deleted elements are released by a background thread */
+static int reclaim = 0;
+
+/* Whether queues are run-length encoded, see rlequeue.h */
+static int rle = 0;
+
+/* Whether queues are persistent deques, see pdeque.h */
+static int persistent = 0;
+
+/* Implementation of queues of strings, as an index in queue_backends.
+ * Anything but 0 means the elements are not element_t, see backend.h
+ */
+static int backend = 0;
+
+/* Type of the keys held by queues, see tqueue.h */
+typedef enum {
+    KEYS_STRING, /* strings in element_t */
+    KEYS_INT64,  /* 64-bit integers */
+    KEYS_16,     /* strings of up to 16 bytes, padded with NUL bytes */
+} keys_mode_t;
+static int keys = KEYS_STRING;
+
+/* A key of the type in use */
+typedef union {
+    int64_t i64;
+    key16_t k16;
+} any_key_t;
+
+/* Room for any key printed as text */
+#define KEY_TEXT_SIZE 24
+
+/* Snapshots taken from persistent queues */
+static queue_chain_t snapshots = {.size = 0};
+static int snapshot_id = 0;
+
 #define MIN_RANDSTR_LEN 5
 #define MAX_RANDSTR_LEN 10
 static const char charset[] = "abcdefghijklmnopqrstuvwxyz";
@@ -86,6 +143,134 @@ typedef enum {
 /* Forward declarations */
 static bool q_show(int vlevel);
 
+/* Count the elements of a queue of whichever representation is in use */
+static int queue_size(struct list_head *q)
+{
+    if (rle)
+        return rq_size(q);
+    if (persistent)
+        return pd_size(q);
+    if (backend)
+        return queue_backend->size(q);
+    if (keys)
+        return keys == KEYS_INT64 ? i64q_size(q) : k16q_size(q);
+    return q_size(q);
+}
+
+/* Release a queue of whichever representation is in use */
+static void queue_free(struct list_head *q)
+{
+    if (rle)
+        rq_free(q);
+    else if (persistent)
+        pd_free(q);
+    else if (backend)
+        queue_backend->release(q);
+    else if (keys == KEYS_INT64)
+        i64q_free(q);
+    else if (keys == KEYS_16)
+        k16q_free(q);
+    else
+        q_free(q);
+}
+
+/* Parse @s as a key of the type in use */
+static bool parse_key(const char *s, any_key_t *key)
+{
+    if (keys == KEYS_INT64) {
+        char *end;
+        errno = 0;
+        long long val = strtoll(s, &end, 10);
+        if (errno || end == s || *end)
+            return false;
+        key->i64 = val;
+        return true;
+    }
+
+    size_t len = strlen(s);
+    if (len > sizeof(key->k16.bytes))
+        return false;
+    memset(key->k16.bytes, 0, sizeof(key->k16.bytes));
+    memcpy(key->k16.bytes, s, len);
+    return true;
+}
+
+/* Print @key the way it is written in commands */
+static void format_key(const any_key_t *key, char *buf, size_t size)
+{
+    if (keys == KEYS_INT64)
+        snprintf(buf, size, "%" PRId64, key->i64);
+    else
+        snprintf(buf, size, "%.*s", (int) sizeof(key->k16.bytes),
+                 (const char *) key->k16.bytes);
+}
+
+static int cmp_key(const any_key_t *a, const any_key_t *b)
+{
+    if (keys == KEYS_INT64)
+        return (a->i64 > b->i64) - (a->i64 < b->i64);
+    return memcmp(a->k16.bytes, b->k16.bytes, sizeof(a->k16.bytes));
+}
+
+/* Read the key of a node of a queue of keys */
+static any_key_t key_of(const struct list_head *node)
+{
+    any_key_t key;
+    if (keys == KEYS_INT64)
+        key.i64 = list_entry(node, i64q_element_t, list)->key;
+    else
+        key.k16 = list_entry(node, k16q_element_t, list)->key;
+    return key;
+}
+
+/* Copy up to @n keys from the head of queue @q */
+static size_t peek_keys(struct list_head *q, any_key_t *out, size_t n)
+{
+    size_t got = 0;
+    struct list_head *node;
+    list_for_each(node, q) {
+        if (got == n)
+            break;
+        out[got++] = key_of(node);
+    }
+    return got;
+}
+
+/* Get the first strings of a queue whose elements are not element_t */
+static size_t queue_peek(struct list_head *q, const char **out, size_t n)
+{
+    if (backend)
+        return queue_backend->peek(q, out, n);
+    if (keys) {
+        static char text[BIG_LIST_SIZE][KEY_TEXT_SIZE];
+        any_key_t key[BIG_LIST_SIZE];
+        size_t got = peek_keys(q, key, n < BIG_LIST_SIZE ? n : BIG_LIST_SIZE);
+        for (size_t i = 0; i < got; i++) {
+            format_key(&key[i], text[i], KEY_TEXT_SIZE);
+            out[i] = text[i];
+        }
+        return got;
+    }
+    return pd_peek(q, out, n);
+}
+
+/* Whether queues are in another representation than a list of element_t */
+static inline bool alt_mode()
+{
+    return rle || persistent || backend || keys;
+}
+
+static bool mode_unsupported(const char *cmd)
+{
+    if (backend)
+        report(1, "ERROR: '%s' is not supported by the %s backend", cmd,
+               queue_backend->name);
+    else
+        report(1, "ERROR: '%s' is not supported in %s mode", cmd,
+               rle ? "RLE" : persistent ? "persistent" : "key");
+    return false;
+}
+
 static bool do_free(int argc, char *argv[])
 {
     if (argc != 1) {
@@ -114,7 +299,7 @@ static bool do_free(int argc, char *argv[])
         list_del(&current->chain);
 
         if (exception_setup(true))
-            q_free(current->q);
+            queue_free(current->q);
         exception_cancel();
         set_cautious_mode(true);
     }
@@ -127,8 +312,13 @@ static bool do_free(int argc, char *argv[])
 
     q_show(3);
 
-    size_t bcnt = allocation_check();
-    if (!chain.size && bcnt > 0) {
+    size_t bcnt = 0;
+    if (!chain.size && !pq && !snapshots.size) {
+        /* Settle the accounting of the elements still pending release */
+        reclaim_wait();
+        bcnt = allocation_check();
+    }
+    if (bcnt > 0) {
         report(1,
                "ERROR: There is no queue, but %lu blocks are still allocated",
                bcnt);
@@ -152,7 +342,16 @@ static bool do_new(int argc, char *argv[])
         list_add_tail(&qctx->chain, &chain.head);
 
         qctx->size = 0;
-        qctx->q = q_new();
+        if (rle)
+            qctx->q = rq_new();
+        else if (persistent)
+            qctx->q = pd_new();
+        else if (backend)
+            qctx->q = queue_backend->new();
+        else if (keys)
+            qctx->q = keys == KEYS_INT64 ? i64q_new() : k16q_new();
+        else
+            qctx->q = q_new();
         qctx->id = chain.size++;
 
         current = qctx;
@@ -163,6 +362,320 @@ static bool do_new(int argc, char *argv[])
     return ok && !error_check();
 }
 
+/* Whether the backend in use stores queues in files, reporting if not */
+static bool file_backend(const char *cmd)
+{
+    if (backend && queue_backend->open)
+        return true;
+    if (backend)
+        return mode_unsupported(cmd);
+    report(1, "ERROR: '%s' needs a backend storing queues in files, such as "
+              "'option backend mmap'", cmd);
+    return false;
+}
+
+/* Open the queue stored in a file as a new queue */
+static bool do_open(int argc, char *argv[])
+{
+    if (argc != 2) {
+        report(1, "%s needs a file", argv[0]);
+        return false;
+    }
+    if (!file_backend(argv[0]))
+        return false;
+
+    struct list_head *q = NULL;
+    if (exception_setup(true))
+        q = queue_backend->open(argv[1]);
+    exception_cancel();
+    if (!q) {
+        report(1, "ERROR: Could not open a queue in file %s (or it is open)",
+               argv[1]);
+        return false;
+    }
+
+    queue_contex_t *qctx = malloc(sizeof(queue_contex_t));
+    list_add_tail(&qctx->chain, &chain.head);
+    qctx->q = q;
+    qctx->size = queue_backend->size(q);
+    qctx->id = chain.size++;
+    current = qctx;
+
+    q_show(3);
+    return !error_check();
+}
+
+/* Make the current queue durable in its file */
+static bool do_sync(int argc, char *argv[])
+{
+    if (argc != 1) {
+        report(1, "%s takes no arguments", argv[0]);
+        return false;
+    }
+    if (!file_backend(argv[0]))
+        return false;
+    if (!current) {
+        report(3, "Warning: Calling sync on null queue");
+        return !error_check();
+    }
+
+    bool ok = false;
+    if (exception_setup(true))
+        ok = queue_backend->sync(current->q);
+    exception_cancel();
+    if (!ok)
+        report(1, "ERROR: Could not sync the queue to its file");
+    return ok && !error_check();
+}
+
+/* A session file holds SESSION_MAGIC, the number of queues and the position of
+ * the current one in the chain, then for each queue in the order of the chain
+ * its id, its size and its strings. Every number is a varint (see varint.h)
+ * and every string is prefixed by its length.
+ */
+#define SESSION_MAGIC "lab0-ss1"
+
+/* Write every queue of the chain to a file */
+static bool do_save(int argc, char *argv[])
+{
+    if (argc != 2) {
+        report(1, "%s needs a file", argv[0]);
+        return false;
+    }
+    if (alt_mode() && !backend)
+        return mode_unsupported(argv[0]);
+
+    FILE *file = fopen(argv[1], "wb");
+    if (!file) {
+        report(1, "ERROR: Could not open %s for writing", argv[1]);
+        return false;
+    }
+
+    uint64_t pos = 0, cur = chain.size;
+    queue_contex_t *qctx;
+    list_for_each_entry(qctx, &chain.head, chain) {
+        if (qctx == current)
+            cur = pos;
+        pos++;
+    }
+    bool ok = fwrite(SESSION_MAGIC, 1, 8, file) == 8 &&
+              varint_put(file, chain.size) && varint_put(file, cur);
+
+    const char **values = NULL;
+    size_t capacity = 0;
+    list_for_each_entry(qctx, &chain.head, chain) {
+        if (!ok)
+            break;
+        size_t n = queue_backend->size(qctx->q);
+        if (n > capacity) {
+            free(values);
+            capacity = n;
+            values = malloc(capacity * sizeof(char *));
+            if (!values) {
+                report(1, "INTERNAL ERROR.  Could not allocate space for "
+                          "saving queues");
+                fclose(file);
+                return false;
+            }
+        }
+        n = queue_backend->peek(qctx->q, values, n);
+        ok = varint_put(file, qctx->id) && varint_put(file, n);
+        for (size_t i = 0; ok && i < n; i++) {
+            size_t len = strlen(values[i]);
+            ok = varint_put(file, len) &&
+                 fwrite(values[i], 1, len, file) == len;
+        }
+    }
+    free(values);
+
+    if (fclose(file))
+        ok = false;
+    if (!ok)
+        report(1, "ERROR: Could not write %s", argv[1]);
+    return ok;
+}
+
+/* Read a whole file into a new buffer */
+static unsigned char *read_file(const char *name, size_t *size)
+{
+    FILE *file = fopen(name, "rb");
+    if (!file)
+        return NULL;
+
+    struct stat st;
+    unsigned char *buf = NULL;
+    if (!fstat(fileno(file), &st)) {
+        *size = st.st_size;
+        buf = malloc(*size ? *size : 1);
+        if (buf && fread(buf, 1, *size, file) != *size) {
+            free(buf);
+            buf = NULL;
+        }
+    }
+    fclose(file);
+    return buf;
+}
+
+/* Check a session file, finding the length of its longest string */
+static bool session_check(const unsigned char *p,
+                          const unsigned char *end,
+                          size_t *maxlen)
+{
+    uint64_t count, cur, id, n, len;
+
+    if (end - p < 8 || memcmp(p, SESSION_MAGIC, 8))
+        return false;
+    p += 8;
+    if (!varint_get(&p, end, &count) || !varint_get(&p, end, &cur) ||
+        count > INT_MAX || cur > count)
+        return false;
+
+    *maxlen = 0;
+    for (uint64_t i = 0; i < count; i++) {
+        if (!varint_get(&p, end, &id) || !varint_get(&p, end, &n) ||
+            id > INT_MAX || n > INT_MAX)
+            return false;
+        for (uint64_t j = 0; j < n; j++) {
+            if (!varint_get(&p, end, &len) || len > (uint64_t) (end - p))
+                return false;
+            p += len;
+            if (len > *maxlen)
+                *maxlen = len;
+        }
+    }
+    return p == end;
+}
+
+/* Restore the queues written by save, which become the chain */
+static bool do_load(int argc, char *argv[])
+{
+    if (argc != 2) {
+        report(1, "%s needs a file", argv[0]);
+        return false;
+    }
+    if (alt_mode() && !backend)
+        return mode_unsupported(argv[0]);
+    if (chain.size) {
+        report(1, "ERROR: Free all queues before loading");
+        return false;
+    }
+
+    /* One read of the whole file, checked before any queue is created */
+    size_t size, maxlen;
+    unsigned char *buf = read_file(argv[1], &size);
+    if (!buf) {
+        report(1, "ERROR: Could not read %s", argv[1]);
+        return false;
+    }
+    const unsigned char *p = buf + 8, *end = buf + size;
+    char *str = NULL;
+    if (!session_check(buf, end, &maxlen) || !(str = malloc(maxlen + 1))) {
+        report(1, "ERROR: %s is not a session file", argv[1]);
+        free(buf);
+        return false;
+    }
+
+    uint64_t count, cur, id, n, len;
+    varint_get(&p, end, &count);
+    varint_get(&p, end, &cur);
+
+    bool ok = true;
+    if (exception_setup(true)) {
+        for (uint64_t i = 0; ok && i < count; i++) {
+            varint_get(&p, end, &id);
+            varint_get(&p, end, &n);
+
+            queue_contex_t *qctx = malloc(sizeof(queue_contex_t));
+            list_add_tail(&qctx->chain, &chain.head);
+            qctx->q = queue_backend->new();
+            qctx->id = id;
+            qctx->size = 0;
+            chain.size++;
+            if (i == cur)
+                current = qctx;
+
+            for (uint64_t j = 0; ok && j < n; j++) {
+                varint_get(&p, end, &len);
+                memcpy(str, p, len);
+                str[len] = '\0';
+                p += len;
+                ok = queue_backend->insert_tail(qctx->q, str);
+                if (ok)
+                    qctx->size++;
+            }
+        }
+    }
+    exception_cancel();
+    free(str);
+    free(buf);
+
+    if (!ok)
+        report(1, "ERROR: Could not restore every element");
+    q_show(3);
+    return ok && !error_check();
+}
+
+/* Insert every line of a file at the tail of the current queue */
+static bool do_loadfile(int argc, char *argv[])
+{
+    if (argc != 2) {
+        report(1, "%s needs a file", argv[0]);
+        return false;
+    }
+    if (alt_mode())
+        return mode_unsupported(argv[0]);
+    if (!current || !current->q) {
+        report(3, "Warning: Calling loadfile on null queue");
+        return !error_check();
+    }
+
+    int n = -1;
+    if (exception_setup(true))
+        n = q_load_file(current->q, argv[1]);
+    exception_cancel();
+    if (n < 0) {
+        report(1, "ERROR: Could not load %s", argv[1]);
+        return false;
+    }
+    current->size += n;
+    report(3, "Loaded %d elements", n);
+
+    q_show(3);
+    return !error_check();
+}
+
+/* Write every string of the current queue to a file, one per line */
+static bool do_dump(int argc, char *argv[])
+{
+    if (argc != 2) {
+        report(1, "%s needs a file", argv[0]);
+        return false;
+    }
+    if (alt_mode())
+        return mode_unsupported(argv[0]);
+    if (!current || !current->q) {
+        report(3, "Warning: Calling dump on null queue");
+        return !error_check();
+    }
+
+    int n = -1;
+    set_noallocate_mode(true);
+    if (exception_setup(true))
+        n = q_dump_file(current->q, argv[1]);
+    exception_cancel();
+    set_noallocate_mode(false);
+    if (n < 0) {
+        report(1, "ERROR: Could not dump to %s", argv[1]);
+        return false;
+    }
+    if (n != current->size) {
+        report(1, "ERROR: Dumped %d elements instead of %d", n, current->size);
+        return false;
+    }
+    report(3, "Dumped %d elements", n);
+    return !error_check();
+}
+
 /* TODO: Add a buf_size check of if the buf_size may be less
  * than MIN_RANDSTR_LEN.
  */
@@ -180,6 +693,122 @@ static void fill_rand_string(char *buf, size_t buf_size)
     buf[len] = '\0';
 }
 
+/* Insertion into a queue of keys. @inserts is parsed once, unless random keys
+ * are requested.
+ */
+static bool keys_insert(position_t pos, char *inserts, bool need_rand, int reps)
+{
+    any_key_t key;
+    if (!need_rand && !parse_key(inserts, &key)) {
+        report(1, "ERROR: Invalid key '%s'", inserts);
+        return false;
+    }
+
+    bool ok = true;
+    for (int r = 0; ok && r < reps; r++) {
+        if (need_rand && keys == KEYS_INT64) {
+            uint32_t val;
+            randombytes((uint8_t *) &val, sizeof(val));
+            key.i64 = val;
+        } else if (need_rand) {
+            fill_rand_string(inserts, MAX_RANDSTR_LEN);
+            parse_key(inserts, &key);
+        }
+
+        bool rval;
+        if (keys == KEYS_INT64)
+            rval = pos == POS_TAIL ? i64q_insert_tail(current->q, key.i64)
+                                   : i64q_insert_head(current->q, key.i64);
+        else
+            rval = pos == POS_TAIL ? k16q_insert_tail(current->q, key.k16)
+                                   : k16q_insert_head(current->q, key.k16);
+        if (rval) {
+            current->size++;
+        } else {
+            fail_count++;
+            if (fail_count < fail_limit)
+                report(2, "Insertion of %s failed", inserts);
+            else {
+                report(1, "ERROR: Insertion of %s failed (%d failures total)",
+                       inserts, fail_count);
+                ok = false;
+            }
+        }
+        ok = ok && !error_check();
+    }
+    return ok;
+}
+
+/* Insertion into a run-length encoded or persistent queue, or a queue of
+ * another backend. A repeated string is inserted as a single run in RLE mode,
+ * and none of these representations exposes its elements as element_t, so
+ * there is no per-element copy to verify.
+ */
+static bool alt_insert(position_t pos, char *inserts, bool need_rand, int reps)
+{
+    if (keys)
+        return keys_insert(pos, inserts, need_rand, reps);
+
+    bool ok = true;
+    int batch = rle && !need_rand ? reps : 1;
+    for (int r = 0; ok && r < reps; r += batch) {
+        bool rval;
+        if (need_rand)
+            fill_rand_string(inserts, MAX_RANDSTR_LEN);
+        if (rle)
+            rval = pos == POS_TAIL ? rq_insert_tail(current->q, inserts, batch)
+                                   : rq_insert_head(current->q, inserts, batch);
+        else if (backend)
+            rval = pos == POS_TAIL
+                       ? queue_backend->insert_tail(current->q, inserts)
+                       : queue_backend->insert_head(current->q, inserts);
+        else
+            rval = pos == POS_TAIL ? pd_insert_tail(current->q, inserts)
+                                   : pd_insert_head(current->q, inserts);
+        if (rval) {
+            current->size += batch;
+        } else {
+            fail_count++;
+            if (fail_count < fail_limit)
+                report(2, "Insertion of %s failed", inserts);
+            else {
+                report(1, "ERROR: Insertion of %s failed (%d failures total)",
+                       inserts, fail_count);
+                ok = false;
+            }
+        }
+        ok = ok && !error_check();
+    }
+    return ok;
+}
+
+/* Removal from a queue which has no element to hand back */
+static bool alt_remove(position_t pos, char *removes, size_t bufsize)
+{
+    if (keys) {
+        any_key_t key;
+        bool ok;
+        if (keys == KEYS_INT64)
+            ok = pos == POS_TAIL ? i64q_remove_tail(current->q, &key.i64)
+                                 : i64q_remove_head(current->q, &key.i64);
+        else
+            ok = pos == POS_TAIL ? k16q_remove_tail(current->q, &key.k16)
+                                 : k16q_remove_head(current->q, &key.k16);
+        if (ok)
+            format_key(&key, removes, bufsize);
+        return ok;
+    }
+    if (rle)
+        return pos == POS_TAIL ? rq_remove_tail(current->q, removes, bufsize)
+                               : rq_remove_head(current->q, removes, bufsize);
+    if (backend)
+        return pos == POS_TAIL
+                   ? queue_backend->remove_tail(current->q, removes, bufsize)
+                   : queue_backend->remove_head(current->q, removes, bufsize);
+    return pos == POS_TAIL ? pd_remove_tail(current->q, removes, bufsize)
+                           : pd_remove_head(current->q, removes, bufsize);
+}
+
 /* insertion */
 static bool queue_insert(position_t pos, int argc, char *argv[])
 {
@@ -226,7 +855,9 @@ static bool queue_insert(position_t pos, int argc, char *argv[])
                pos == POS_TAIL ? "tail" : "head");
     error_check();
 
-    if (current && exception_setup(true)) {
+    if (current && alt_mode() && exception_setup(true)) {
+        ok = alt_insert(pos, inserts, need_rand, reps);
+    } else if (current && exception_setup(true)) {
         for (int r = 0; ok && r < reps; r++) {
             if (need_rand)
                 fill_rand_string(randstr_buf, sizeof(randstr_buf));
@@ -248,7 +879,7 @@ static bool queue_insert(position_t pos, int argc, char *argv[])
                            "queue element");
                     ok = false;
                     break;
-                } else if (r == 1 && lasts == cur_inserts) {
+                } else if (r == 1 && lasts == cur_inserts && !intern) {
                     report(1,
                            "ERROR: Need to allocate separate string for each "
                            "queue element");
@@ -290,6 +921,10 @@ static bool do_it(int argc, char *argv[])
 
 static bool queue_remove(position_t pos, int argc, char *argv[])
 {
+    /* A singly-linked queue cannot reach the element before its tail */
+    if (pos == POS_TAIL && !queue_backend->remove_tail)
+        return mode_unsupported(argv[0]);
+
     /* FIXME: It is known that both functions is_remove_tail_const() and
      * is_remove_head_const() can not pass dudect on Apple M1 (based on Arm64).
      * We shall figure out the exact reasons and resolve later.
@@ -349,18 +984,22 @@ static bool queue_remove(position_t pos, int argc, char *argv[])
     error_check();
 
     element_t *re = NULL;
-    if (current && exception_setup(true))
+    bool is_null = true;
+    if (current && alt_mode() && exception_setup(true))
+        is_null = !alt_remove(pos, removes, string_length + 1);
+    else if (current && exception_setup(true)) {
         re = pos == POS_TAIL
                  ? q_remove_tail(current->q, removes, string_length + 1)
                  : q_remove_head(current->q, removes, string_length + 1);
+        is_null = !re;
+    }
     exception_cancel();
 
-    bool is_null = re ? false : true;
-
     if (!is_null) {
         // q_remove_head and q_remove_tail are not responsible for releasing
         // node
-        q_release_element(re);
+        if (re)
+            q_release_element(re);
 
         removes[string_length + STRINGPAD] = '\0';
         if (removes[0] == '\0') {
@@ -417,28 +1056,200 @@ static inline bool do_rt(int argc, char *argv[])
     return queue_remove(POS_TAIL, argc, argv);
 }
 
-static bool do_dedup(int argc, char *argv[])
+/* Check rq_delete_dup() against the singleton runs it must leave behind */
+static bool rle_dedup()
 {
-    if (argc != 1) {
-        report(1, "%s takes no arguments", argv[0]);
+    size_t nkeep = 0;
+    rle_element_t *run;
+    list_for_each_entry(run, current->q, list)
+        nkeep += run->count == 1;
+
+    char **keep = malloc(sizeof(char *) * (nkeep ? nkeep : 1));
+    if (!keep) {
+        report(1,
+               "INTERNAL ERROR.  Could not allocate space for duplicate "
+               "checking");
         return false;
     }
+    size_t i = 0;
+    list_for_each_entry(run, current->q, list) {
+        if (run->count == 1)
+            keep[i++] = strdup(run->value);
+    }
 
-    if (!current || !current->q) {
-        report(3, "Warning: Try to access null queue");
-        return false;
+    bool ok = true;
+    if (exception_setup(true))
+        ok = rq_delete_dup(current->q);
+    exception_cancel();
+
+    if (!ok) {
+        report(1, "ERROR: Calling delete duplicate on null queue");
+    } else {
+        /* Decode the result and compare it element by element */
+        i = 0;
+        list_for_each_entry(run, current->q, list) {
+            for (size_t n = 0; ok && n < run->count; n++, i++)
+                ok = i < nkeep && !strcmp(run->value, keep[i]);
+        }
+        ok = ok && i == nkeep;
+        if (!ok)
+            report(1,
+                   "ERROR: Duplicate strings are in queue or distinct strings "
+                   "are not in queue");
+        current->size = nkeep;
     }
 
-    LIST_HEAD(l_copy);
-    element_t *item = NULL, *tmp = NULL;
+    for (i = 0; i < nkeep; i++)
+        free(keep[i]);
+    free(keep);
 
-    // Copy current->q to l_copy
-    if (current->q && !list_empty(current->q)) {
-        list_for_each_entry(item, current->q, list) {
-            size_t slen;
-            tmp = malloc(sizeof(element_t));
-            if (!tmp)
-                break;
+    q_show(3);
+    return ok && !error_check();
+}
+
+/* Delete duplicate keys and compare with the keys expected to remain */
+static bool keys_dedup()
+{
+    size_t n = current->size;
+    any_key_t *before = malloc((n ? n : 1) * sizeof(any_key_t));
+    if (!before) {
+        report(1, "INTERNAL ERROR.  Could not allocate space for duplicate "
+                  "checking");
+        return false;
+    }
+    peek_keys(current->q, before, n);
+
+    bool ok = true;
+    if (n > BIG_LIST_SIZE)
+        set_cautious_mode(false);
+    if (exception_setup(true)) {
+        ok = keys == KEYS_INT64 ? i64q_delete_dup(current->q)
+                                : k16q_delete_dup(current->q);
+    }
+    exception_cancel();
+    set_cautious_mode(true);
+    if (!ok) {
+        free(before);
+        report(1, "ERROR: Calling delete duplicate on null queue");
+        return false;
+    }
+
+    /* Keep the keys not equal to either neighbour */
+    size_t kept = 0;
+    for (size_t i = 0; i < n; i++) {
+        if ((i == 0 || cmp_key(&before[i - 1], &before[i])) &&
+            (i + 1 == n || cmp_key(&before[i], &before[i + 1])))
+            before[kept++] = before[i];
+    }
+
+    size_t i = 0;
+    struct list_head *node;
+    list_for_each(node, current->q) {
+        any_key_t key = key_of(node);
+        if (i == kept || cmp_key(&before[i], &key)) {
+            ok = false;
+            break;
+        }
+        i++;
+    }
+    if (!ok || i != kept)
+        report(1,
+               "ERROR: Duplicate keys are in queue or distinct keys are not "
+               "in queue");
+    current->size = queue_size(current->q);
+    free(before);
+
+    q_show(3);
+    return ok && i == kept && !error_check();
+}
+
+/* Delete duplicates from a queue of another backend, checking the strings
+ * kept against a copy of those not equal to either neighbour.
+ */
+static bool backend_dedup(const char *cmd)
+{
+    if (!queue_backend->delete_dup)
+        return mode_unsupported(cmd);
+
+    size_t n = current->size, kept = 0;
+    const char **values = malloc((n ? n : 1) * sizeof(char *));
+    char **expected = malloc((n ? n : 1) * sizeof(char *));
+    if (!values || !expected) {
+        free(values);
+        free(expected);
+        report(1, "INTERNAL ERROR.  Could not allocate space for duplicate "
+                  "checking");
+        return false;
+    }
+    n = queue_backend->peek(current->q, values, n);
+    for (size_t i = 0; i < n; i++) {
+        if ((i == 0 || strcmp(values[i - 1], values[i])) &&
+            (i + 1 == n || strcmp(values[i], values[i + 1])))
+            expected[kept++] = strdup(values[i]);
+    }
+
+    bool ok = true;
+    if (n > BIG_LIST_SIZE)
+        set_cautious_mode(false);
+    if (exception_setup(true))
+        ok = queue_backend->delete_dup(current->q);
+    exception_cancel();
+    set_cautious_mode(true);
+
+    if (!ok) {
+        report(1, "ERROR: Calling delete duplicate on null queue");
+    } else {
+        size_t got = queue_backend->peek(current->q, values, kept + 1);
+        for (size_t i = 0; ok && i < got; i++)
+            ok = i < kept && !strcmp(values[i], expected[i]);
+        if (!ok || got != kept) {
+            report(1,
+                   "ERROR: Duplicate strings are in queue or distinct strings "
+                   "are not in queue");
+            ok = false;
+        }
+    }
+    current->size = queue_size(current->q);
+    for (size_t i = 0; i < kept; i++)
+        free(expected[i]);
+    free(expected);
+    free(values);
+
+    q_show(3);
+    return ok && !error_check();
+}
+
+static bool do_dedup(int argc, char *argv[])
+{
+    if (argc != 1) {
+        report(1, "%s takes no arguments", argv[0]);
+        return false;
+    }
+
+    if (!current || !current->q) {
+        report(3, "Warning: Try to access null queue");
+        return false;
+    }
+
+    if (rle)
+        return rle_dedup();
+    if (keys)
+        return keys_dedup();
+    if (backend)
+        return backend_dedup(argv[0]);
+    if (persistent)
+        return mode_unsupported(argv[0]);
+
+    LIST_HEAD(l_copy);
+    element_t *item = NULL, *tmp = NULL;
+
+    // Copy current->q to l_copy
+    if (current->q && !list_empty(current->q)) {
+        list_for_each_entry(item, current->q, list) {
+            size_t slen;
+            tmp = malloc(sizeof(element_t));
+            if (!tmp)
+                break;
             INIT_LIST_HEAD(&tmp->list);
             slen = strlen(item->value) + 1;
             tmp->value = malloc(slen);
@@ -524,8 +1335,20 @@ static bool do_reverse(int argc, char *argv[])
     error_check();
 
     set_noallocate_mode(true);
-    if (current && exception_setup(true))
-        q_reverse(current->q);
+    if (current && exception_setup(true)) {
+        if (rle)
+            rq_reverse(current->q);
+        else if (persistent)
+            pd_reverse(current->q);
+        else if (backend)
+            queue_backend->reverse(current->q);
+        else if (keys == KEYS_INT64)
+            i64q_reverse(current->q);
+        else if (keys == KEYS_16)
+            k16q_reverse(current->q);
+        else
+            q_reverse(current->q);
+    }
     exception_cancel();
 
     set_noallocate_mode(false);
@@ -554,7 +1377,7 @@ static bool do_size(int argc, char *argv[])
 
     if (current && exception_setup(true)) {
         for (int r = 0; ok && r < reps; r++) {
-            cnt = q_size(current->q);
+            cnt = queue_size(current->q);
             ok = ok && !error_check();
         }
     }
@@ -576,10 +1399,234 @@ static bool do_size(int argc, char *argv[])
     return ok && !error_check();
 }
 
+/* Runs must be strictly ordered once equal runs are coalesced */
+static bool rle_sort()
+{
+    if (current && exception_setup(true))
+        rq_sort(current->q, descend);
+    exception_cancel();
+
+    bool ok = true;
+    if (current && current->q && !list_empty(current->q)) {
+        struct list_head *cur_l;
+        for (cur_l = current->q->next; cur_l->next != current->q;
+             cur_l = cur_l->next) {
+            const rle_element_t *run = list_entry(cur_l, rle_element_t, list);
+            const rle_element_t *next =
+                list_entry(cur_l->next, rle_element_t, list);
+            int cmp = strcmp(run->value, next->value);
+            if (descend ? cmp <= 0 : cmp >= 0) {
+                report(1, "ERROR: Runs not sorted in %s order or not coalesced",
+                       descend ? "descending" : "ascending");
+                ok = false;
+                break;
+            }
+        }
+        if (ok && (int) rq_size(current->q) != current->size) {
+            report(1, "ERROR: Sorting changed the number of elements");
+            ok = false;
+        }
+    }
+
+    q_show(3);
+    return ok && !error_check();
+}
+
+/* Sort a queue of another backend and check the order of its strings */
+static bool backend_sort()
+{
+    if (!queue_backend->sort)
+        return mode_unsupported("sort");
+
+    bool ok = true;
+    if (current && exception_setup(true))
+        ok = queue_backend->sort(current->q, descend);
+    exception_cancel();
+    if (!ok) {
+        report(1, "ERROR: Sorting failed");
+        return false;
+    }
+
+    if (current && current->size > 1) {
+        const char **values = malloc(current->size * sizeof(char *));
+        if (!values) {
+            report(1, "INTERNAL ERROR.  Could not allocate space for sort "
+                      "checking");
+            return false;
+        }
+        size_t n = queue_backend->peek(current->q, values, current->size);
+        for (size_t i = 1; ok && i < n; i++) {
+            int cmp = strcmp(values[i - 1], values[i]);
+            if (descend ? cmp < 0 : cmp > 0) {
+                report(1, "ERROR: Not sorted in %s order",
+                       descend ? "descending" : "ascending");
+                ok = false;
+            }
+        }
+        if (ok && (int) n != current->size) {
+            report(1, "ERROR: Sorting changed the number of elements");
+            ok = false;
+        }
+        free(values);
+    }
+
+    q_show(3);
+    return ok && !error_check();
+}
+
+/* Check that the keys of queue @q are in order and that there are @size */
+static bool keys_sorted(struct list_head *q, int size)
+{
+    int count = 0;
+    any_key_t prev, key;
+    struct list_head *node;
+    list_for_each(node, q) {
+        key = key_of(node);
+        int cmp = count ? cmp_key(&prev, &key) : 0;
+        if (descend ? cmp < 0 : cmp > 0) {
+            report(1, "ERROR: Not sorted in %s order",
+                   descend ? "descending" : "ascending");
+            return false;
+        }
+        prev = key;
+        count++;
+    }
+    if (count != size) {
+        report(1, "ERROR: Queue has %d elements, but %d are expected", count,
+               size);
+        return false;
+    }
+    return true;
+}
+
+static bool keys_sort()
+{
+    /* The radix sort of 64-bit keys allocates an array of the nodes */
+    set_noallocate_mode(keys != KEYS_INT64);
+    if (current && exception_setup(true)) {
+        if (keys == KEYS_INT64)
+            i64q_sort(current->q, descend);
+        else
+            k16q_sort(current->q, descend);
+    }
+    exception_cancel();
+    set_noallocate_mode(false);
+
+    bool ok = !current || keys_sorted(current->q, current->size);
+    q_show(3);
+    return ok && !error_check();
+}
+
+/* qsort() comparator on an array of strings */
+static int cmp_string(const void *a, const void *b)
+{
+    return strcmp(*(char *const *) a, *(char *const *) b);
+}
+
+/* Collect copies of the strings appearing exactly once in @ctx, or in every
+ * queue of the chain when @ctx is NULL, in the order expected after sorting.
+ */
+static char **unique_values(queue_contex_t *ctx, size_t *count)
+{
+    size_t total = 0;
+    queue_contex_t *entry;
+    list_for_each_entry(entry, &chain.head, chain) {
+        if (!ctx || entry == ctx)
+            total += q_size(entry->q);
+    }
+
+    char **values = malloc(sizeof(char *) * (total ? total : 1));
+    if (!values) {
+        report(1,
+               "INTERNAL ERROR.  Could not allocate space for duplicate "
+               "checking");
+        return NULL;
+    }
+    size_t n = 0;
+    list_for_each_entry(entry, &chain.head, chain) {
+        if (ctx && entry != ctx)
+            continue;
+        element_t *item;
+        list_for_each_entry(item, entry->q, list)
+            values[n++] = item->value;
+    }
+    qsort(values, n, sizeof(char *), cmp_string);
+
+    /* Keep the singletons, copied since the originals are going to be freed */
+    size_t kept = 0;
+    for (size_t i = 0; i < n;) {
+        size_t j = i + 1;
+        while (j < n && !strcmp(values[i], values[j]))
+            j++;
+        if (j == i + 1)
+            values[kept++] = strdup(values[i]);
+        i = j;
+    }
+    if (descend) {
+        for (size_t i = 0; i < kept / 2; i++) {
+            char *tmp = values[i];
+            values[i] = values[kept - 1 - i];
+            values[kept - 1 - i] = tmp;
+        }
+    }
+
+    *count = kept;
+    return values;
+}
+
+/* Compare queue @q against the values from unique_values() and free them */
+static bool unique_check(struct list_head *q,
+                         char **values,
+                         size_t count,
+                         int len)
+{
+    bool ok = len == (int) count;
+    size_t i = 0;
+    element_t *item;
+    list_for_each_entry(item, q, list) {
+        if (!ok)
+            break;
+        ok = i < count && !strcmp(item->value, values[i]);
+        i++;
+    }
+    ok = ok && i == count;
+    if (!ok)
+        report(1,
+               "ERROR: Not sorted in %s order, duplicate strings are in queue "
+               "or distinct strings are not in queue",
+               descend ? "descending" : "ascending");
+
+    for (i = 0; i < count; i++)
+        free(values[i]);
+    free(values);
+    return ok;
+}
+
+/* Check q_sort_unique() against the sorted singletons of the queue */
+static bool sort_unique()
+{
+    size_t count;
+    char **values = unique_values(current, &count);
+    if (!values)
+        return false;
+
+    int len = 0;
+    if (exception_setup(true))
+        len = q_sort_unique(current->q, descend);
+    exception_cancel();
+
+    bool ok = unique_check(current->q, values, count, len);
+    current->size = q_size(current->q);
+
+    q_show(3);
+    return ok && !error_check();
+}
+
 bool do_sort(int argc, char *argv[])
 {
-    if (argc != 1) {
-        report(1, "%s takes no arguments", argv[0]);
+    bool unique = argc == 2 && !strcmp(argv[1], "-u");
+    if (argc != 1 && !unique) {
+        report(1, "%s takes no arguments other than -u", argv[0]);
         return false;
     }
 
@@ -587,14 +1634,28 @@ bool do_sort(int argc, char *argv[])
     if (!current || !current->q)
         report(3, "Warning: Calling sort on null queue");
     else
-        cnt = q_size(current->q);
+        cnt = queue_size(current->q);
     error_check();
 
     if (cnt < 2)
         report(3, "Warning: Calling sort on single node");
     error_check();
 
-    set_noallocate_mode(true);
+    if (unique && alt_mode())
+        return mode_unsupported("sort -u");
+    if (rle)
+        return rle_sort();
+    if (backend)
+        return backend_sort();
+    if (keys)
+        return keys_sort();
+    if (persistent)
+        return mode_unsupported(argv[0]);
+    if (unique)
+        return current ? sort_unique() : !error_check();
+
+    /* Merging runs allocates the runs and a heap over them */
+    set_noallocate_mode(!sortmem);
 
 /* If the number of elements is too large, it may take a long time to check the
  * stability of the sort. So, MAX_NODES is used to limit the number of elements
@@ -618,6 +1679,11 @@ bool do_sort(int argc, char *argv[])
     set_noallocate_mode(false);
 
     bool ok = true;
+    if (current && (int) q_size(current->q) != current->size) {
+        report(1, "ERROR: Sorting changed the number of elements");
+        cnt = current->size = q_size(current->q);
+        ok = false;
+    }
     if (current && current->size) {
         for (struct list_head *cur_l = current->q->next;
              cur_l != current->q && --cnt; cur_l = cur_l->next) {
@@ -669,6 +1735,9 @@ bool do_sort(int argc, char *argv[])
 
 static bool do_dm(int argc, char *argv[])
 {
+    if (alt_mode())
+        return mode_unsupported(argv[0]);
+
     if (argc != 1) {
         report(1, "%s takes no arguments", argv[0]);
         return false;
@@ -695,6 +1764,9 @@ static bool do_dm(int argc, char *argv[])
 
 static bool do_swap(int argc, char *argv[])
 {
+    if (alt_mode())
+        return mode_unsupported(argv[0]);
+
     if (argc != 1) {
         report(1, "%s takes no arguments", argv[0]);
         return false;
@@ -720,6 +1792,9 @@ static bool do_swap(int argc, char *argv[])
 
 static bool do_ascend(int argc, char *argv[])
 {
+    if (alt_mode())
+        return mode_unsupported(argv[0]);
+
     if (argc != 1) {
         report(1, "%s takes too much arguments", argv[0]);
         return false;
@@ -767,6 +1842,9 @@ static bool do_ascend(int argc, char *argv[])
 
 static bool do_descend(int argc, char *argv[])
 {
+    if (alt_mode())
+        return mode_unsupported(argv[0]);
+
     if (argc != 1) {
         report(1, "%s takes too much arguments", argv[0]);
         return false;
@@ -816,6 +1894,9 @@ static bool do_reverseK(int argc, char *argv[])
 {
     int k = 0;
 
+    if (alt_mode())
+        return mode_unsupported(argv[0]);
+
     if (!current || !current->q) {
         report(3, "Warning: Calling reverseK on null queue");
         return false;
@@ -844,8 +1925,12 @@ static bool do_reverseK(int argc, char *argv[])
 
 static bool do_merge(int argc, char *argv[])
 {
-    if (argc != 1) {
-        report(1, "%s takes no arguments", argv[0]);
+    bool unique = argc == 2 && !strcmp(argv[1], "-u");
+    if (alt_mode() && (!keys || unique))
+        return mode_unsupported(unique ? "merge -u" : argv[0]);
+
+    if (argc != 1 && !unique) {
+        report(1, "%s takes no arguments other than -u", argv[0]);
         return false;
     }
 
@@ -855,10 +1940,19 @@ static bool do_merge(int argc, char *argv[])
     }
     error_check();
 
+    size_t count = 0;
+    char **values = NULL;
+    if (unique && !(values = unique_values(NULL, &count)))
+        return false;
+
+    /* Merging with -u releases the duplicates */
     int len = 0;
-    set_noallocate_mode(true);
+    set_noallocate_mode(!unique);
     if (current && exception_setup(true))
-        len = q_merge(&chain.head, descend);
+        len = keys == KEYS_INT64 ? i64q_merge(&chain.head, descend)
+              : keys == KEYS_16  ? k16q_merge(&chain.head, descend)
+              : unique           ? q_merge_unique(&chain.head, descend)
+                                 : q_merge(&chain.head, descend);
     exception_cancel();
     set_noallocate_mode(false);
 
@@ -871,16 +1965,22 @@ static bool do_merge(int argc, char *argv[])
         while ((uintptr_t) cur != (uintptr_t) &chain.head) {
             queue_contex_t *ctx = list_entry(cur, queue_contex_t, chain);
             cur = cur->next;
-            q_free(ctx->q);
+            queue_free(ctx->q);
             free(ctx);
         }
 
         chain.head.prev = &current->chain;
         current->chain.next = &chain.head;
+    } else if (unique) {
+        current->size = len;
     }
 
     bool ok = true;
-    if (current && current->size) {
+    if (unique)
+        ok = unique_check(current->q, values, count, len);
+    else if (keys && current)
+        ok = keys_sorted(current->q, current->size);
+    else if (current && current->size) {
         for (struct list_head *cur_l = current->q->next;
              cur_l != current->q && --len; cur_l = cur_l->next) {
             /* Ensure each element in ascending order */
@@ -889,27 +1989,620 @@ static bool do_merge(int argc, char *argv[])
             next_item = list_entry(cur_l->next, element_t, list);
             if (!descend && strcmp(item->value, next_item->value) > 0) {
                 report(1,
-                       "ERROR: Not sorted in ascending order (It might because "
-                       "of unsorted queues are merged or there're some flaws "
-                       "in 'q_merge')");
+                       "ERROR: Not sorted in ascending order (It might because "
+                       "of unsorted queues are merged or there're some flaws "
+                       "in 'q_merge')");
+                ok = false;
+                break;
+            }
+
+
+            if (descend && strcmp(item->value, next_item->value) < 0) {
+                report(
+                    1,
+                    "ERROR: Not sorted in descending order (It might because "
+                    "of unsorted queues are merged or there're some flaws "
+                    "in 'q_merge')");
+                ok = false;
+                break;
+            }
+        }
+    }
+
+    q_show(3);
+    return ok && !error_check();
+}
+
+/* Original and final position of an element, for checking stability */
+typedef struct {
+    const element_t *e;
+    int orig, final;
+} elem_pos_t;
+
+static int cmp_pos_addr(const void *a, const void *b)
+{
+    uintptr_t x = (uintptr_t) ((const elem_pos_t *) a)->e;
+    uintptr_t y = (uintptr_t) ((const elem_pos_t *) b)->e;
+    return (x > y) - (x < y);
+}
+
+/* Order of a stable sort: by value, then by original position */
+static int cmp_pos_stable(const void *a, const void *b)
+{
+    const elem_pos_t *x = a, *y = b;
+    int cmp = strcmp(x->e->value, y->e->value);
+    if (descend)
+        cmp = -cmp;
+    return cmp ? cmp : x->orig - y->orig;
+}
+
+/* Record the position of every element of @q, sorted by address for lookup */
+static elem_pos_t *record_positions(struct list_head *q, int n)
+{
+    elem_pos_t *pos = malloc(sizeof(elem_pos_t) * (n ? n : 1));
+    if (!pos) {
+        report(1,
+               "INTERNAL ERROR.  Could not allocate space for stability "
+               "checking");
+        return NULL;
+    }
+    int i = 0;
+    const element_t *item;
+    list_for_each_entry(item, q, list) {
+        pos[i].e = item;
+        pos[i].orig = i;
+        i++;
+    }
+    qsort(pos, n, sizeof(elem_pos_t), cmp_pos_addr);
+    return pos;
+}
+
+static elem_pos_t *find_position(elem_pos_t *pos, int n, const element_t *e)
+{
+    elem_pos_t key = {.e = e};
+    return bsearch(&key, pos, n, sizeof(elem_pos_t), cmp_pos_addr);
+}
+
+static bool do_nth(int argc, char *argv[])
+{
+    if (alt_mode())
+        return mode_unsupported(argv[0]);
+
+    bool stable = argc == 3 && !strcmp(argv[2], "-s");
+    int k = 0;
+    if ((argc != 2 && !stable) || !get_int(argv[1], &k)) {
+        report(1, "%s takes a position and an optional -s", argv[0]);
+        return false;
+    }
+
+    if (!current || !current->q) {
+        report(3, "Warning: Calling nth on null queue");
+        return false;
+    }
+    error_check();
+
+    int cnt = current->size;
+    elem_pos_t *pos = NULL;
+    if (stable && !(pos = record_positions(current->q, cnt)))
+        return false;
+
+    element_t *nth = NULL;
+    set_noallocate_mode(true);
+    if (exception_setup(true))
+        nth = q_nth_element(current->q, k, descend);
+    exception_cancel();
+    set_noallocate_mode(false);
+
+    bool ok = true;
+    if (k < 0 || k >= cnt) {
+        if (nth) {
+            report(1, "ERROR: Found an element at out of range position %d",
+                   k);
+            ok = false;
+        }
+    } else if (!nth) {
+        report(1, "ERROR: No element found at position %d", k);
+        ok = false;
+    } else {
+        report(2, "Element at position %d is %s", k, nth->value);
+
+        /* Ensure the queue is partitioned around the element */
+        int i = 0;
+        element_t *item;
+        list_for_each_entry(item, current->q, list) {
+            int cmp = strcmp(item->value, nth->value);
+            if (descend)
+                cmp = -cmp;
+            if (i == k ? item != nth : i < k ? cmp > 0 : cmp < 0) {
+                report(1,
+                       "ERROR: Queue not partitioned around position %d in %s "
+                       "order",
+                       k, descend ? "descending" : "ascending");
+                ok = false;
+                break;
+            }
+            if (pos) {
+                elem_pos_t *p = find_position(pos, cnt, item);
+                if (p)
+                    p->final = i;
+            }
+            i++;
+        }
+        if (ok && i != cnt) {
+            report(1, "ERROR: Selecting changed the number of elements");
+            ok = false;
+        }
+
+        /* Ensure the element is the one a stable sort puts at position k,
+         * and that equal strings keep their relative order.
+         */
+        if (ok && pos) {
+            qsort(pos, cnt, sizeof(elem_pos_t), cmp_pos_stable);
+            bool unstable = pos[k].e != nth;
+            for (i = 1; !unstable && i < cnt; i++) {
+                unstable = !strcmp(pos[i - 1].e->value, pos[i].e->value) &&
+                           pos[i - 1].final > pos[i].final;
+            }
+            if (unstable) {
+                report(1,
+                       "ERROR: Not stable selection. The duplicate strings are "
+                       "not in the same order.");
+                ok = false;
+            }
+        }
+    }
+    free(pos);
+
+    q_show(3);
+    return ok && !error_check();
+}
+
+static bool do_partition(int argc, char *argv[])
+{
+    if (alt_mode())
+        return mode_unsupported(argv[0]);
+
+    bool stable = argc == 3 && !strcmp(argv[2], "-s");
+    if (argc != 2 && !stable) {
+        report(1, "%s takes a pivot and an optional -s", argv[0]);
+        return false;
+    }
+
+    if (!current || !current->q) {
+        report(3, "Warning: Calling partition on null queue");
+        return false;
+    }
+    error_check();
+
+    int cnt = current->size;
+    elem_pos_t *pos = NULL;
+    if (stable && !(pos = record_positions(current->q, cnt)))
+        return false;
+
+    queue_contex_t *qctx = malloc(sizeof(queue_contex_t));
+    if (!qctx || !(qctx->q = q_new())) {
+        free(qctx);
+        free(pos);
+        report(1, "ERROR: Could not allocate queue for partition");
+        return false;
+    }
+    qctx->size = 0;
+    qctx->id = chain.size++;
+    list_add_tail(&qctx->chain, &chain.head);
+
+    const char *pivot = argv[1];
+    int moved = 0;
+    set_noallocate_mode(true);
+    if (exception_setup(true))
+        moved = q_partition(current->q, qctx->q, pivot, descend);
+    exception_cancel();
+    set_noallocate_mode(false);
+
+    current->size = q_size(current->q);
+    qctx->size = q_size(qctx->q);
+    report(2, "Moved %d elements to queue %d", moved, qctx->id);
+
+    bool ok = true;
+    if (moved != qctx->size || current->size + qctx->size != cnt) {
+        report(1, "ERROR: Partitioning changed the number of elements");
+        ok = false;
+    }
+
+    /* Ensure each element is in the right queue, in its original order */
+    const struct list_head *queues[] = {current->q, qctx->q};
+    for (int n = 0; ok && n < 2; n++) {
+        int last = -1;
+        const element_t *item;
+        list_for_each_entry(item, queues[n], list) {
+            int cmp = strcmp(item->value, pivot);
+            if (descend)
+                cmp = -cmp;
+            if (n ? cmp < 0 : cmp >= 0) {
+                report(1, "ERROR: %s is in the wrong queue", item->value);
+                ok = false;
+                break;
+            }
+            const elem_pos_t *p = pos ? find_position(pos, cnt, item) : NULL;
+            if (p && p->orig < last) {
+                report(1,
+                       "ERROR: Not stable partition. %s is not in its "
+                       "original order.",
+                       item->value);
+                ok = false;
+                break;
+            }
+            if (p)
+                last = p->orig;
+        }
+    }
+    free(pos);
+
+    q_show(3);
+    return ok && !error_check();
+}
+
+/* Queue receiving the i-th of @n elements scattered over @k ranges */
+static int range_of(int i, int n, int k)
+{
+    int len = n / k, big = n % k * (len + 1);
+    return i < big ? i / (len + 1) : n % k + (i - big) / len;
+}
+
+static bool do_scatter(int argc, char *argv[])
+{
+    if (alt_mode())
+        return mode_unsupported(argv[0]);
+
+    static const char *const modes[] = {
+        [SCATTER_ROUND_ROBIN] = "rr",
+        [SCATTER_HASH] = "hash",
+        [SCATTER_RANGE] = "range",
+    };
+    scatter_mode_t mode = SCATTER_ROUND_ROBIN;
+    if (argc == 2) {
+        while (mode <= SCATTER_RANGE && strcmp(argv[1], modes[mode]))
+            mode++;
+    }
+    if (argc > 2 || mode > SCATTER_RANGE) {
+        report(1, "%s takes an optional mode: rr, hash or range", argv[0]);
+        return false;
+    }
+
+    if (!current || !current->q) {
+        report(3, "Warning: Calling scatter on null queue");
+        return false;
+    }
+    error_check();
+
+    queue_contex_t *first =
+        list_first_entry(&chain.head, queue_contex_t, chain);
+    int cnt = first->size, k = chain.size;
+    elem_pos_t *pos = record_positions(first->q, cnt);
+    if (!pos)
+        return false;
+
+    bool ok = false;
+    if (exception_setup(true))
+        ok = q_scatter(&chain.head, mode);
+    exception_cancel();
+
+    if (!ok) {
+        report(1, "ERROR: Could not scatter the queue");
+        free(pos);
+        return false;
+    }
+
+    /* Ensure each queue received the right elements in their original order.
+     * Elements already in the other queues are skipped.
+     */
+    int shard = 0, total = 0;
+    queue_contex_t *ctx;
+    list_for_each_entry(ctx, &chain.head, chain) {
+        int last = -1, i = 0;
+        const element_t *item;
+        list_for_each_entry(item, ctx->q, list) {
+            elem_pos_t *p = find_position(pos, cnt, item);
+            i++;
+            if (!p)
+                continue;
+            p->final = shard;
+            total++;
+            if (p->orig < last ||
+                (mode == SCATTER_ROUND_ROBIN && p->orig % k != shard) ||
+                (mode == SCATTER_RANGE && range_of(p->orig, cnt, k) != shard)) {
+                report(1, "ERROR: %s is at the wrong place in queue %d",
+                       item->value, ctx->id);
+                ok = false;
+                break;
+            }
+            last = p->orig;
+        }
+        if (ok && i != ctx->size) {
+            report(1, "ERROR: Size of queue %d is %d, but should be %d",
+                   ctx->id, ctx->size, i);
+            ok = false;
+        }
+        if (!ok)
+            break;
+        shard++;
+    }
+    if (ok && total != cnt) {
+        report(1, "ERROR: Scattering changed the number of elements");
+        ok = false;
+    }
+
+    /* Equal strings must share a queue when scattered by hash */
+    if (ok && mode == SCATTER_HASH) {
+        qsort(pos, cnt, sizeof(elem_pos_t), cmp_pos_stable);
+        for (int i = 1; ok && i < cnt; i++) {
+            ok = strcmp(pos[i - 1].e->value, pos[i].e->value) ||
+                 pos[i - 1].final == pos[i].final;
+        }
+        if (!ok)
+            report(1, "ERROR: Equal strings are scattered to different queues");
+    }
+    free(pos);
+
+    q_show(3);
+    return ok && !error_check();
+}
+
+static bool do_gather(int argc, char *argv[])
+{
+    if (alt_mode())
+        return mode_unsupported(argv[0]);
+
+    if (argc != 1) {
+        report(1, "%s takes no arguments", argv[0]);
+        return false;
+    }
+
+    if (!current || !current->q) {
+        report(3, "Warning: Calling gather on null queue");
+        return false;
+    }
+    error_check();
+
+    int total = 0;
+    queue_contex_t *ctx;
+    list_for_each_entry(ctx, &chain.head, chain)
+        total += ctx->size;
+
+    int len = 0;
+    set_noallocate_mode(true);
+    if (exception_setup(true))
+        len = q_gather(&chain.head);
+    exception_cancel();
+    set_noallocate_mode(false);
+
+    bool ok = true;
+    queue_contex_t *first =
+        list_first_entry(&chain.head, queue_contex_t, chain);
+    list_for_each_entry(ctx, &chain.head, chain) {
+        int expected = ctx == first ? total : 0;
+        if (ctx->size != expected || q_size(ctx->q) != expected) {
+            report(1, "ERROR: Queue %d holds %d elements, but should hold %d",
+                   ctx->id, q_size(ctx->q), expected);
+            ok = false;
+            break;
+        }
+    }
+    if (ok && len != total) {
+        report(1, "ERROR: Gathered %d elements, but should be %d", len, total);
+        ok = false;
+    }
+
+    q_show(3);
+    return ok && !error_check();
+}
+
+static bool do_compact(int argc, char *argv[])
+{
+    if (alt_mode())
+        return mode_unsupported(argv[0]);
+
+    if (argc != 1) {
+        report(1, "%s takes no arguments", argv[0]);
+        return false;
+    }
+
+    if (!current || !current->q) {
+        report(3, "Warning: Calling compact on null queue");
+        return false;
+    }
+    error_check();
+
+    /* Keep the strings in order to check nothing moved in the list */
+    int cnt = current->size;
+    char **values = malloc(sizeof(char *) * (cnt ? cnt : 1));
+    if (!values) {
+        report(1,
+               "INTERNAL ERROR.  Could not allocate space for compaction "
+               "checking");
+        return false;
+    }
+    int i = 0;
+    element_t *item;
+    list_for_each_entry(item, current->q, list) {
+        if (i < cnt)
+            values[i] = strdup(item->value);
+        i++;
+    }
+    cnt = i < cnt ? i : cnt;
+
+    if (current->size > BIG_LIST_SIZE)
+        set_cautious_mode(false);
+
+    bool ok = false;
+    if (exception_setup(true))
+        ok = q_compact(current->q);
+    exception_cancel();
+    set_cautious_mode(true);
+
+    /* The queue must be left unchanged when allocation fails */
+    if (!ok) {
+        ok = ++fail_count < fail_limit;
+        if (ok)
+            report(2, "Compaction failed");
+        else
+            report(1, "ERROR: Compaction failed (%d failures total)",
+                   fail_count);
+    }
+
+    i = 0;
+    list_for_each_entry(item, current->q, list) {
+        if (i >= cnt || strcmp(item->value, values[i])) {
+            report(1, "ERROR: Compaction changed the content of the queue");
+            ok = false;
+            break;
+        }
+        i++;
+    }
+    if (ok && i != cnt) {
+        report(1, "ERROR: Compaction changed the number of elements");
+        ok = false;
+    }
+
+    for (i = 0; i < cnt; i++)
+        free(values[i]);
+    free(values);
+
+    q_show(3);
+    return ok && !error_check();
+}
+
+static bool pq_show(int vlevel)
+{
+    if (verblevel < vlevel)
+        return true;
+
+    if (!pq) {
+        report(vlevel, "pq = NULL");
+        return true;
+    }
+
+    report(vlevel, "pq = [%s%s] (size %d)", pq_peek(pq),
+           pq->size > 1 ? " ..." : "", pq->size);
+    return true;
+}
+
+static bool do_pq_push(int argc, char *argv[])
+{
+    char randstr_buf[MAX_RANDSTR_LEN];
+    int reps = 1;
+    bool ok = true, need_rand = false;
+    if (argc != 2 && argc != 3) {
+        report(1, "%s needs 1-2 arguments", argv[0]);
+        return false;
+    }
+
+    char *inserts = argv[1];
+    if (argc == 3) {
+        if (!get_int(argv[2], &reps) || reps < 1) {
+            report(1, "Invalid number of insertions '%s'", argv[2]);
+            return false;
+        }
+    }
+
+    if (!strcmp(inserts, "RAND")) {
+        need_rand = true;
+        inserts = randstr_buf;
+    }
+
+    if (exception_setup(true)) {
+        if (!pq)
+            pq = pq_new(descend);
+        else
+            pq_set_order(pq, descend);
+
+        for (int r = 0; ok && pq && r < reps; r++) {
+            if (need_rand)
+                fill_rand_string(randstr_buf, sizeof(randstr_buf));
+            if (!pq_push(pq, inserts)) {
+                fail_count++;
+                if (fail_count < fail_limit)
+                    report(2, "Insertion of %s failed", inserts);
+                else {
+                    report(1,
+                           "ERROR: Insertion of %s failed (%d failures total)",
+                           inserts, fail_count);
+                    ok = false;
+                }
+            } else if (pq_peek(pq) == inserts) {
+                report(1,
+                       "ERROR: Need to allocate and copy string for new "
+                       "priority queue element");
                 ok = false;
-                break;
             }
+            ok = ok && !error_check();
+        }
+    }
+    exception_cancel();
 
+    if (pq && !pq->size) {
+        pq_free(pq);
+        pq = NULL;
+    }
 
-            if (descend && strcmp(item->value, next_item->value) < 0) {
-                report(
-                    1,
-                    "ERROR: Not sorted in descending order (It might because "
-                    "of unsorted queues are merged or there're some flaws "
-                    "in 'q_merge')");
-                ok = false;
-                break;
-            }
+    pq_show(3);
+    return ok && !error_check();
+}
+
+static bool do_pq_pop(int argc, char *argv[])
+{
+    if (argc != 1 && argc != 2) {
+        report(1, "%s needs 0-1 arguments", argv[0]);
+        return false;
+    }
+
+    char *removes = malloc(string_length + 1);
+    if (!removes) {
+        report(1,
+               "INTERNAL ERROR.  Could not allocate space for removed strings");
+        return false;
+    }
+    removes[0] = '\0';
+
+    if (!pq)
+        report(3, "Warning: Calling pop on empty priority queue");
+    error_check();
+
+    pq_element_t *re = NULL;
+    if (pq && exception_setup(true)) {
+        pq_set_order(pq, descend);
+        re = pq_pop(pq, removes, string_length + 1);
+    }
+    exception_cancel();
+
+    bool ok = true;
+    if (re) {
+        pq_release_element(re);
+        report(2, "Removed %s from priority queue", removes);
+        if (argc == 2 && strcmp(removes, argv[1])) {
+            report(1, "ERROR: Removed value %s != expected value %s", removes,
+                   argv[1]);
+            ok = false;
+        }
+    } else {
+        fail_count++;
+        if (argc == 1 && fail_count < fail_limit) {
+            report(2, "Removal from priority queue failed");
+        } else {
+            report(1,
+                   "ERROR: Removal from priority queue failed (%d failures "
+                   "total)",
+                   fail_count);
+            ok = false;
         }
     }
 
-    q_show(3);
+    if (pq && !pq->size) {
+        pq_free(pq);
+        pq = NULL;
+    }
+
+    pq_show(3);
+    free(removes);
     return ok && !error_check();
 }
 
@@ -937,6 +2630,39 @@ static bool is_circular()
     return true;
 }
 
+/* Show the first elements of a queue whose elements are not element_t, or of
+ * a snapshot
+ */
+static bool alt_show(int vlevel,
+                     const char *name,
+                     struct list_head *q,
+                     int size)
+{
+    const char *values[BIG_LIST_SIZE];
+    int cnt = 0;
+
+    if (exception_setup(true))
+        cnt = queue_peek(q, values, BIG_LIST_SIZE);
+    exception_cancel();
+
+    report_noreturn(vlevel, "%s = [", name);
+    for (int i = 0; i < cnt; i++) {
+        report_noreturn(vlevel, i == 0 ? "%s" : " %s", values[i]);
+        if (show_entropy) {
+            report_noreturn(vlevel, "(%3.2f%%)",
+                            shannon_entropy((const uint8_t *) values[i]));
+        }
+    }
+    report(vlevel, size > BIG_LIST_SIZE ? " ... ]" : "]");
+
+    if (queue_size(q) != size) {
+        report(vlevel, "ERROR:  Queue has %d elements, but %d are expected",
+               queue_size(q), size);
+        return false;
+    }
+    return !error_check();
+}
+
 static bool q_show(int vlevel)
 {
     bool ok = true;
@@ -949,6 +2675,9 @@ static bool q_show(int vlevel)
         return true;
     }
 
+    if (persistent || backend || keys)
+        return alt_show(vlevel, "l", current->q, current->size);
+
     if (!is_circular()) {
         report(vlevel, "ERROR:  Queue is not doubly circular");
         return false;
@@ -961,16 +2690,27 @@ static bool q_show(int vlevel)
 
     if (exception_setup(true)) {
         while (ok && ori != cur && cnt < current->size) {
-            element_t *e = list_entry(cur, element_t, list);
-            if (cnt < BIG_LIST_SIZE) {
-                report_noreturn(vlevel, cnt == 0 ? "%s" : " %s", e->value);
+            const char *value;
+            size_t repeat = 1;
+            if (rle) {
+                const rle_element_t *run =
+                    list_entry(cur, rle_element_t, list);
+                value = run->value;
+                repeat = run->count;
+            } else {
+                value = list_entry(cur, element_t, list)->value;
+            }
+            for (; repeat > 0; repeat--, cnt++) {
+                if (cnt >= BIG_LIST_SIZE) {
+                    cnt += (int) repeat;
+                    break;
+                }
+                report_noreturn(vlevel, cnt == 0 ? "%s" : " %s", value);
                 if (show_entropy) {
-                    report_noreturn(
-                        vlevel, "(%3.2f%%)",
-                        shannon_entropy((const uint8_t *) e->value));
+                    report_noreturn(vlevel, "(%3.2f%%)",
+                                    shannon_entropy((const uint8_t *) value));
                 }
             }
-            cnt++;
             cur = cur->next;
             ok = ok && !error_check();
         }
@@ -1010,6 +2750,121 @@ static bool do_show(int argc, char *argv[])
     return q_show(0);
 }
 
+static void snapshots_free()
+{
+    queue_contex_t *snap, *tmp;
+    list_for_each_entry_safe(snap, tmp, &snapshots.head, chain) {
+        pd_free(snap->q);
+        free(snap);
+    }
+    INIT_LIST_HEAD(&snapshots.head);
+    snapshots.size = 0;
+}
+
+static queue_contex_t *find_snapshot(int id)
+{
+    queue_contex_t *snap;
+    list_for_each_entry(snap, &snapshots.head, chain) {
+        if (snap->id == id)
+            return snap;
+    }
+    return NULL;
+}
+
+static bool do_snapshot(int argc, char *argv[])
+{
+    if (argc != 1 && argc != 2) {
+        report(1, "%s takes 0-1 arguments", argv[0]);
+        return false;
+    }
+
+    if (!persistent) {
+        report(1, "ERROR: '%s' requires 'option persistent 1'", argv[0]);
+        return false;
+    }
+
+    if (argc == 2) {
+        int id;
+        const queue_contex_t *snap;
+        if (!get_int(argv[1], &id) || !(snap = find_snapshot(id))) {
+            report(1, "Unknown snapshot '%s'", argv[1]);
+            return false;
+        }
+        return alt_show(0, "s", snap->q, snap->size);
+    }
+
+    if (!current || !current->q) {
+        report(3, "Warning: Calling snapshot on null queue");
+        return false;
+    }
+
+    queue_contex_t *snap = malloc(sizeof(queue_contex_t));
+    if (!snap) {
+        report(1, "INTERNAL ERROR.  Could not allocate space for snapshot");
+        return false;
+    }
+
+    snap->q = NULL;
+    if (exception_setup(true))
+        snap->q = pd_snapshot(current->q);
+    exception_cancel();
+
+    if (!snap->q) {
+        free(snap);
+        report(1, "ERROR: Could not take snapshot");
+        return false;
+    }
+
+    snap->size = current->size;
+    snap->id = snapshot_id++;
+    list_add_tail(&snap->chain, &snapshots.head);
+    snapshots.size++;
+    report(2, "Snapshot %d of queue %d taken", snap->id, current->id);
+
+    return !error_check();
+}
+
+static bool do_restore(int argc, char *argv[])
+{
+    if (argc != 1 && argc != 2) {
+        report(1, "%s takes 0-1 arguments", argv[0]);
+        return false;
+    }
+
+    if (!persistent) {
+        report(1, "ERROR: '%s' requires 'option persistent 1'", argv[0]);
+        return false;
+    }
+
+    if (!current || !current->q) {
+        report(3, "Warning: Calling restore on null queue");
+        return false;
+    }
+
+    const queue_contex_t *snap = NULL;
+    if (argc == 2) {
+        int id;
+        if (!get_int(argv[1], &id) || !(snap = find_snapshot(id))) {
+            report(1, "Unknown snapshot '%s'", argv[1]);
+            return false;
+        }
+    } else if (snapshots.size) {
+        snap = list_last_entry(&snapshots.head, queue_contex_t, chain);
+    } else {
+        report(1, "ERROR: No snapshot to restore");
+        return false;
+    }
+
+    if (exception_setup(true)) {
+        pd_restore(current->q, snap->q);
+        current->size = snap->size;
+    }
+    exception_cancel();
+
+    q_show(3);
+    return !error_check();
+}
+
 static bool do_prev(int argc, char *argv[])
 {
     if (argc != 1) {
@@ -1056,10 +2911,275 @@ static bool do_next(int argc, char *argv[])
     return q_show(0);
 }
 
+static void set_intern(int oldval)
+{
+    set_intern_mode(intern);
+}
+
+static void set_sortmem(int oldval)
+{
+    if (sortmem < 0) {
+        report(1, "ERROR: Sort memory must be a number of kilobytes");
+        sortmem = oldval;
+    }
+    ext_sort_budget = (size_t) sortmem << 10;
+}
+
+static void set_reclaim(int oldval)
+{
+    if (reclaim && !oldval) {
+        set_concurrent_mode(true);
+        if (!reclaim_start()) {
+            report(1, "ERROR: Could not start the reclaimer thread");
+            set_concurrent_mode(false);
+            reclaim = 0;
+        }
+    } else if (!reclaim && oldval) {
+        reclaim_stop();
+        set_concurrent_mode(false);
+    }
+}
+
+/* Queues have a single representation, which may only change while there is
+ * no queue. Put @mode back to @oldval and return false otherwise.
+ */
+static bool switch_mode(int *mode, int oldval, const char *name)
+{
+    if (chain.size && *mode != oldval) {
+        report(1, "ERROR: Free all queues before switching %s mode", name);
+    } else if (*mode && !!rle + !!persistent + !!backend + !!keys > 1) {
+        report(1,
+               "ERROR: RLE, persistent and key modes only work with the list "
+               "backend");
+    } else {
+        return true;
+    }
+    *mode = oldval;
+    return false;
+}
+
+static void set_rle(int oldval)
+{
+    switch_mode(&rle, oldval, "RLE");
+}
+
+static void set_persistent(int oldval)
+{
+    if (switch_mode(&persistent, oldval, "persistent") && !persistent)
+        snapshots_free();
+}
+
+/* Move the only queue between the list and arena backends, which both hand
+ * the strings over instead of copying them. Return false if allocation
+ * failed, leaving the queue as it was.
+ */
+static bool convert_queue(int from, int to)
+{
+    struct list_head *q = queue_backends[to]->new();
+    bool ok = q && (from ? aq_to_list(current->q, q)
+                         : aq_from_list(q, current->q));
+    if (!ok) {
+        queue_backends[to]->release(q);
+        return false;
+    }
+    queue_backends[from]->release(current->q);
+    current->q = q;
+    return true;
+}
+
+static void set_backend(int oldval)
+{
+    int arena = backend_find("arena");
+    if (chain.size == 1 && current->q && !rle && !persistent && !keys &&
+        ((!oldval && backend == arena) || (oldval == arena && !backend))) {
+        if (!convert_queue(oldval, backend)) {
+            report(1, "ERROR: Could not convert the queue to the %s backend",
+                   queue_backends[backend]->name);
+            backend = oldval;
+        }
+    } else {
+        switch_mode(&backend, oldval, "backend");
+    }
+    queue_backend = queue_backends[backend];
+}
+
+static void set_keys(int oldval)
+{
+    if (keys < KEYS_STRING || keys > KEYS_16) {
+        report(1, "ERROR: Key type must be 0, 1 or 2");
+        keys = oldval;
+    } else {
+        switch_mode(&keys, oldval, "key");
+    }
+}
+
+/* Show the counters of queue.c since last time and clear them. Comparisons and
+ * node visits are also given relative to n * log2(n), for the size n of the
+ * current queue.
+ */
+static bool do_stats(int argc, char *argv[])
+{
+    if (argc != 1) {
+        report(1, "%s takes no arguments", argv[0]);
+        return false;
+    }
+
+#ifndef QUEUE_STATS
+    /* Not an error, so that traces reading the counters run in any build */
+    report(1, "Counters are compiled out, rebuild with 'make STATS=1'");
+    return true;
+#else
+    int n = current && current->q ? current->size : 0;
+    double bound = n > 1 ? n * log2(n) : 0;
+    const struct {
+        const char *name;
+        uint64_t count;
+        bool bounded;
+    } counters[] = {
+        {"compares", queue_stats.compares, true},
+        {"hops", queue_stats.hops, true},
+        {"merges", queue_stats.merges, false},
+    };
+
+    report(1, "Counters for n = %d:", n);
+    for (size_t i = 0; i < sizeof(counters) / sizeof(counters[0]); i++) {
+        if (counters[i].bounded && bound > 0)
+            report(1, "  %-10s%14" PRIu64 "  (%.2f n log2 n)", counters[i].name,
+                   counters[i].count, counters[i].count / bound);
+        else
+            report(1, "  %-10s%14" PRIu64, counters[i].name,
+                   counters[i].count);
+    }
+    memset(&queue_stats, 0, sizeof(queue_stats));
+    return true;
+#endif
+}
+
+/* Free every queue, the priority queue and the snapshots */
+static void queues_free()
+{
+    struct list_head *cur = chain.head.next;
+    while (chain.size > 0) {
+        queue_contex_t *qctx = list_entry(cur, queue_contex_t, chain);
+        cur = cur->next;
+        queue_free(qctx->q);
+        free(qctx);
+        chain.size--;
+    }
+    INIT_LIST_HEAD(&chain.head);
+    current = NULL;
+    pq_free(pq);
+    pq = NULL;
+    snapshots_free();
+}
+
+static bool do_replay(int argc, char *argv[])
+{
+    if (argc < 2) {
+        report(1, "%s needs a file and optionally backends", argv[0]);
+        return false;
+    }
+
+    if (chain.size || pq) {
+        report(1, "ERROR: Free all queues before replaying");
+        return false;
+    }
+
+    if (alt_mode() && !backend) {
+        report(1, "ERROR: Replaying needs queues of strings");
+        return false;
+    }
+
+    /* Default to every backend */
+    int count = argc > 2 ? argc - 2 : queue_backend_count;
+    int *ids = malloc(count * sizeof(int));
+    double *elapsed = malloc(count * sizeof(double));
+    if (!ids || !elapsed) {
+        free(ids);
+        free(elapsed);
+        report(1, "INTERNAL ERROR.  Could not allocate space for replaying");
+        return false;
+    }
+
+    bool ok = true;
+    for (int i = 0; ok && i < count; i++) {
+        ids[i] = argc > 2 ? backend_find(argv[i + 2]) : i;
+        if (ids[i] < 0) {
+            report(1, "Unknown backend '%s'", argv[i + 2]);
+            ok = false;
+        }
+    }
+
+    /* Runs which complete without errors, the only ones timed */
+    int done = 0;
+    int saved = backend;
+    for (int i = 0; ok && i < count; i++) {
+        backend = ids[i];
+        queue_backend = queue_backends[backend];
+        report(2, "Replaying %s against the %s backend", argv[1],
+               queue_backend->name);
+
+        int errors = cmd_error_count();
+        double start;
+        delta_time(&start);
+        if (!run_source(argv[1])) {
+            report(1, "ERROR: Could not open source file '%s'", argv[1]);
+            ok = false;
+        }
+        elapsed[i] = delta_time(&start);
+        if (ok && (cmd_quitting() || cmd_error_count() != errors)) {
+            report(1, "ERROR: Replay against the %s backend failed",
+                   queue_backend->name);
+            ok = false;
+        }
+        if (ok)
+            done++;
+
+        /* Start the next run from scratch */
+        if (current && current->size > BIG_LIST_SIZE)
+            set_cautious_mode(false);
+        if (exception_setup(true))
+            queues_free();
+        exception_cancel();
+        set_cautious_mode(true);
+    }
+    backend = saved;
+    queue_backend = queue_backends[backend];
+
+    if (done) {
+        report(1, "%-12s%12s%12s", "backend", "time (s)", "relative");
+        for (int i = 0; i < done; i++) {
+            report(1, "%-12s%12.3f%12.2f", queue_backends[ids[i]]->name,
+                   elapsed[i], elapsed[0] > 0 ? elapsed[i] / elapsed[0] : 1.0);
+        }
+    }
+    free(ids);
+    free(elapsed);
+    return ok && !error_check();
+}
+
 static void console_init()
 {
     ADD_COMMAND(new, "Create new queue", "");
     ADD_COMMAND(free, "Delete queue", "");
+    ADD_COMMAND(open,
+                "Open the queue stored in file as a new queue, creating it "
+                "if missing (needs a file backend)",
+                "file");
+    ADD_COMMAND(sync,
+                "Make current queue durable in its file, compacting the file "
+                "once most of it is garbage",
+                "");
+    ADD_COMMAND(save,
+                "Write every queue with its id, in the order of the chain, "
+                "to file",
+                "file");
+    ADD_COMMAND(load, "Restore the queues written by save", "file");
+    ADD_COMMAND(loadfile,
+                "Insert every line of file at tail of current queue", "file");
+    ADD_COMMAND(dump,
+                "Write every string of current queue to file, one per line",
+                "file");
     ADD_COMMAND(prev, "Switch to previous queue", "");
     ADD_COMMAND(next, "Switch to next queue", "");
     ADD_COMMAND(ih,
@@ -1079,12 +3199,33 @@ static void console_init()
         "Remove from tail of queue. Optionally compare to expected value str",
         "[str]");
     ADD_COMMAND(reverse, "Reverse queue", "");
-    ADD_COMMAND(sort, "Sort queue in ascending/descening order", "");
+    ADD_COMMAND(sort,
+                "Sort queue in ascending/descening order, -u also deletes "
+                "duplicate strings",
+                "[-u]");
     ADD_COMMAND(size, "Compute queue size n times (default: n == 1)", "[n]");
     ADD_COMMAND(show, "Show queue contents", "");
     ADD_COMMAND(dm, "Delete middle node in queue", "");
     ADD_COMMAND(dedup, "Delete all nodes that have duplicate string", "");
-    ADD_COMMAND(merge, "Merge all the queues into one sorted queue", "");
+    ADD_COMMAND(merge,
+                "Merge all the queues into one sorted queue, -u also deletes "
+                "duplicate strings",
+                "[-u]");
+    ADD_COMMAND(nth,
+                "Find the element at position k of the sorted queue, -s also "
+                "checks stability",
+                "k [-s]");
+    ADD_COMMAND(partition,
+                "Move elements not ordered before pivot to a new queue, -s "
+                "also checks stability",
+                "pivot [-s]");
+    ADD_COMMAND(scatter,
+                "Distribute the first queue over all queues by round-robin, "
+                "hash or contiguous ranges",
+                "[rr|hash|range]");
+    ADD_COMMAND(gather, "Concatenate all queues into the first queue", "");
+    ADD_COMMAND(compact,
+                "Relocate elements of queue in list order for locality", "");
     ADD_COMMAND(swap, "Swap every two adjacent nodes in queue", "");
     ADD_COMMAND(ascend,
                 "Remove every node which has a node with a strictly less "
@@ -1096,14 +3237,60 @@ static void console_init()
                 "");
     ADD_COMMAND(reverseK, "Reverse the nodes of the queue 'K' at a time",
                 "[K]");
+    ADD_COMMAND(snapshot,
+                "Take snapshot of queue in persistent mode, or show snapshot "
+                "id",
+                "[id]");
+    ADD_COMMAND(restore,
+                "Restore queue from snapshot id in persistent mode (default: "
+                "latest snapshot)",
+                "[id]");
+    ADD_COMMAND(pq_push,
+                "Push string str into priority queue n times. Generate random "
+                "string(s) if str equals RAND. (default: n == 1)",
+                "str [n]");
+    ADD_COMMAND(pq_pop,
+                "Pop smallest (largest if descend) string from priority "
+                "queue. Optionally compare to expected value str",
+                "[str]");
+    ADD_COMMAND(stats,
+                "Show and clear the comparisons, node visits and merges "
+                "counted since last time (needs make STATS=1)",
+                "");
+    ADD_COMMAND(replay,
+                "Run the commands of file against each backend (default: "
+                "all) and report their times side by side",
+                "file [backend ...]");
     add_param("length", &string_length, "Maximum length of displayed string",
               NULL);
     add_param("malloc", &fail_probability, "Malloc failure probability percent",
               NULL);
     add_param("fail", &fail_limit,
               "Number of times allow queue operations to return false", NULL);
+    add_param("intern", &intern,
+              "Share one reference-counted copy of identical strings",
+              set_intern);
+    add_param("sortmem", &sortmem,
+              "Kilobytes of strings sort sorts at once, merging larger "
+              "queues from runs of that size, 0 for no limit",
+              set_sortmem);
+    add_param("reclaim", &reclaim,
+              "Release deleted elements in a background thread", set_reclaim);
+    add_param("rle", &rle, "Use run-length encoded queues", set_rle);
+    add_param("persistent", &persistent,
+              "Use persistent queues supporting snapshot and restore",
+              set_persistent);
+    add_enum_param("backend", &backend, backend_names(),
+                   "Implementation of queues of strings, see replay; a single "
+                   "queue is converted between list and arena",
+                   set_backend);
+    add_param("keys", &keys,
+              "Key type of queues: 0 for strings, 1 for 64-bit integers, 2 "
+              "for 16-byte keys",
+              set_keys);
     add_param("descend", &descend,
-              "Sort and merge queue in ascending/descending order", NULL);
+              "Sort, merge and pop queues in ascending/descending order",
+              NULL);
 }
 
 /* Signal handlers */
@@ -1129,6 +3316,7 @@ static void q_init()
 {
     fail_count = 0;
     INIT_LIST_HEAD(&chain.head);
+    INIT_LIST_HEAD(&snapshots.head);
     signal(SIGSEGV, sigsegv_handler);
     signal(SIGALRM, sigalrm_handler);
 }
@@ -1139,20 +3327,14 @@ static bool q_quit(int argc, char *argv[])
     if (current && current->size > BIG_LIST_SIZE)
         set_cautious_mode(false);
 
-    if (exception_setup(true)) {
-        struct list_head *cur = chain.head.next;
-        while (chain.size > 0) {
-            queue_contex_t *qctx = list_entry(cur, queue_contex_t, chain);
-            cur = cur->next;
-            q_free(qctx->q);
-            free(qctx);
-            chain.size--;
-        }
-    }
+    if (exception_setup(true))
+        queues_free();
 
     exception_cancel();
     set_cautious_mode(true);
 
+    /* Settle the accounting of the elements still pending release */
+    reclaim_stop();
     size_t bcnt = allocation_check();
     if (bcnt > 0) {
         report(1, "ERROR: Freed queue, but %lu blocks are still allocated",
@@ -1165,8 +3347,9 @@ static bool q_quit(int argc, char *argv[])
 
 static void usage(char *cmd)
 {
-    printf("Usage: %s [-h] [-f IFILE][-v VLEVEL][-l LFILE]\n", cmd);
+    printf("Usage: %s [-h] [-c] [-f IFILE][-v VLEVEL][-l LFILE]\n", cmd);
     printf("\t-h         Print this information\n");
+    printf("\t-c         Cache compiled command files next to them\n");
     printf("\t-f IFILE   Read commands from IFILE\n");
     printf("\t-v VLEVEL  Set verbosity level\n");
     printf("\t-l LFILE   Echo results to LFILE\n");
@@ -1382,11 +3565,14 @@ int main(int argc, char *argv[])
     int level = 4;
     int c;
 
-    while ((c = getopt(argc, argv, "hv:f:l:")) != -1) {
+    while ((c = getopt(argc, argv, "hcv:f:l:")) != -1) {
         switch (c) {
         case 'h':
             usage(argv[0]);
             break;
+        case 'c':
+            set_cmd_cache(true);
+            break;
         case 'f':
             strncpy(buf, optarg, BUFSIZE);
             buf[BUFSIZE - 1] = '\0';
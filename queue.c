@@ -1,8 +1,29 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
 
+#include "extsort.h"
 #include "queue.h"
+#include "reclaim.h"
+#include "stats.h"
+
+queue_stats_t queue_stats;
+
+/* Interned strings share storage, so equal pointers mean equal strings */
+static inline bool value_equal(const char *a, const char *b)
+{
+    if (a == b)
+        return true;
+    STATS_INC(compares);
+    return !strcmp(a, b);
+}
 
 /* Create an empty queue */
 struct list_head *q_new()
@@ -19,10 +40,7 @@ void q_free(struct list_head *head)
 {
     if (!head)
         return;
-    struct list_head *entry, *safe;
-    list_for_each_safe(entry, safe, head) {
-        q_release_element(list_entry(entry, element_t, list));
-    }
+    reclaim_list(head);
     free(head);
 }
 
@@ -127,23 +145,24 @@ bool q_delete_dup(struct list_head *head)
     if (!head || head->next == head)
         return false;
 
-    struct list_head *node, *safe;
+    LIST_HEAD(removed);
+    element_t *element, *element_safe;
+    struct list_head *ahead;
     bool last_duplicate = false;
 
-    list_for_each_safe(node, safe, head) {
-        element_t *element = list_entry(node, element_t, list);
-        const element_t *element_safe = list_entry(safe, element_t, list);
-
-        if (safe != head && strcmp(element->value, element_safe->value) == 0) {
+    list_for_each_entry_safe_prefetch(element, element_safe, ahead, head, list,
+                                      value) {
+        STATS_INC(hops);
+        if (&element_safe->list != head &&
+            value_equal(element->value, element_safe->value)) {
             last_duplicate = true;
-            list_del(node);
-            q_release_element(element);
+            list_move_tail(&element->list, &removed);
         } else if (last_duplicate) {
             last_duplicate = false;
-            list_del(node);
-            q_release_element(element);
+            list_move_tail(&element->list, &removed);
         }
     }
+    reclaim_list(&removed);
 
     return true;
 }
@@ -209,10 +228,17 @@ struct list_head *merge(struct list_head *left,
     INIT_LIST_HEAD(&merged);
     struct list_head *cur = &merged;
 
+    STATS_INC(merges);
     while (left && right) {
         const element_t *left_elem = list_entry(left, element_t, list);
         const element_t *right_elem = list_entry(right, element_t, list);
 
+        /* Either head may be taken, fetch the node that would replace it */
+        list_prefetch(left->next);
+        list_prefetch(right->next);
+
+        STATS_INC(hops);
+        STATS_INC(compares);
         int cmp = strcmp(left_elem->value, right_elem->value);
         if (descend)
             cmp = -cmp;
@@ -226,112 +252,367 @@ struct list_head *merge(struct list_head *left,
         }
         cur = cur->next;
     }
-    if (left)
-        cur->next = left;
-    if (right)
-        cur->next = right;
+    cur->next = left ? left : right;
 
     return merged.next;
 }
 
-struct list_head *merge_sort(struct list_head *head, bool descend)
+/* Order two elements by their strings, @priv points to the descend flag */
+static inline int element_cmp(void *priv,
+                              const struct list_head *a,
+                              const struct list_head *b)
 {
-    if (!head || !head->next)
-        return head;
+    STATS_INC(compares);
+    int cmp = strcmp(list_entry(a, element_t, list)->value,
+                     list_entry(b, element_t, list)->value);
+    return *(const bool *) priv ? -cmp : cmp;
+}
 
-    struct list_head *slow = head, *mid;
-    for (const struct list_head *fast = head->next; fast && fast->next;
-         fast = fast->next->next) {
-        slow = slow->next;
-    }
-    mid = slow->next;
-    slow->next = NULL;
+#define element_sort_count(event) STATS_INC(event)
 
-    struct list_head *left = merge_sort(head, descend);
-    struct list_head *right = merge_sort(mid, descend);
+LIST_SORT_DEFINE_COUNTED(element_sort, element_cmp, element_sort_count)
 
-    return merge(left, right, descend);
+/* Merge two sorted lists, dropping every string which appears more than once.
+ * Either list may be empty, so this also removes duplicate runs from a single
+ * sorted list.
+ */
+static struct list_head *merge_unique(struct list_head *left,
+                                      struct list_head *right,
+                                      bool descend)
+{
+    struct list_head merged;
+    struct list_head *prev = NULL, *cur = &merged;
+    bool duplicate = false;
+
+    STATS_INC(merges);
+    while (left || right) {
+        struct list_head *node;
+        int cmp = 0;
+        STATS_INC(hops);
+        if (left && right) {
+            STATS_INC(compares);
+            cmp = strcmp(list_entry(left, element_t, list)->value,
+                         list_entry(right, element_t, list)->value);
+            if (descend)
+                cmp = -cmp;
+        }
+
+        if (!right || (left && cmp <= 0)) {
+            node = left;
+            left = left->next;
+        } else {
+            node = right;
+            right = right->next;
+        }
+
+        if (cur != &merged &&
+            value_equal(list_entry(cur, element_t, list)->value,
+                        list_entry(node, element_t, list)->value)) {
+            duplicate = true;
+            q_release_element(list_entry(node, element_t, list));
+            continue;
+        }
+
+        if (duplicate) {
+            q_release_element(list_entry(cur, element_t, list));
+            cur = prev;
+            duplicate = false;
+        }
+        prev = cur;
+        cur->next = node;
+        cur = node;
+    }
+    if (duplicate) {
+        q_release_element(list_entry(cur, element_t, list));
+        cur = prev;
+    }
+    cur->next = NULL;
+
+    return merged.next;
 }
 
-/* Sort elements of queue in ascending/descending order */
-void q_sort(struct list_head *head, bool descend)
+/* Turn a NULL-terminated list back into a circular one, return its length */
+static int restore_circular(struct list_head *head, struct list_head *first)
 {
-    if (!head || list_is_singular(head))
-        return;
-    head->prev->next = NULL;  // break the circular list
-    head->next = merge_sort(head->next, descend);
+    int count = 0;
     struct list_head *cur = head;
+
+    head->next = first;
     while (cur->next) {  // reconnect prev pointer
+        STATS_INC(hops);
         cur->next->prev = cur;
         cur = cur->next;
+        count++;
     }
     cur->next = head;
     head->prev = cur;
-    return;
+    return count;
 }
 
+/* Up to this many distinct strings, sorting groups the equal ones instead */
+#define SORT_FEW_DISTINCT 8
 
-/* Remove every node which has a node with a strictly less value anywhere to
- * the right side of it */
-int q_ascend(struct list_head *head)
+/* Index of @value among the @n distinct strings of @keys, @n if absent */
+static inline int distinct_index(const char *const *keys,
+                                 int n,
+                                 const char *value)
 {
-    // https://leetcode.com/problems/remove-nodes-from-linked-list/
-    if (!head || head->next == head)
+    int i = 0;
+    while (i < n && !value_equal(keys[i], value))
+        i++;
+    return i;
+}
+
+/* Sort a queue holding few distinct strings in O(n * distinct) by moving each
+ * element, in order, to the bucket of its string and joining the buckets.
+ * Runs of equal strings cost one comparison per element. Return false,
+ * leaving the queue untouched, if there are more than SORT_FEW_DISTINCT.
+ */
+static bool sort_few_distinct(struct list_head *head, bool descend)
+{
+    const char *keys[SORT_FEW_DISTINCT];
+    struct list_head buckets[SORT_FEW_DISTINCT];
+    int n = 0, last = 0;
+    element_t *e, *safe;
+
+    list_for_each_entry(e, head, list) {
+        STATS_INC(hops);
+        if (n && value_equal(keys[last], e->value))
+            continue;
+        last = distinct_index(keys, n, e->value);
+        if (last == SORT_FEW_DISTINCT)
+            return false;
+        if (last == n)
+            keys[n++] = e->value;
+    }
+
+    /* Order the distinct strings by insertion */
+    for (int i = 1; i < n; i++) {
+        const char *key = keys[i];
+        int j = i;
+        for (; j > 0; j--) {
+            STATS_INC(compares);
+            int cmp = strcmp(keys[j - 1], key);
+            if (descend ? cmp >= 0 : cmp <= 0)
+                break;
+            keys[j] = keys[j - 1];
+        }
+        keys[j] = key;
+    }
+
+    for (int i = 0; i < n; i++)
+        INIT_LIST_HEAD(&buckets[i]);
+    last = 0;
+    list_for_each_entry_safe(e, safe, head, list) {
+        STATS_INC(hops);
+        if (!value_equal(keys[last], e->value))
+            last = distinct_index(keys, n, e->value);
+        list_move_tail(&e->list, &buckets[last]);
+    }
+    for (int i = 0; i < n; i++)
+        list_splice_tail(&buckets[i], head);
+    return true;
+}
+
+/* Sort elements of queue in ascending/descending order */
+void q_sort(struct list_head *head, bool descend)
+{
+    if (!head || list_empty(head) || sort_few_distinct(head, descend))
+        return;
+    if (ext_sort_budget && ext_sort(head, descend, ext_sort_budget))
+        return;
+    element_sort(&descend, head);
+}
+
+/* Sort elements of queue and delete all nodes that have duplicate string */
+int q_sort_unique(struct list_head *head, bool descend)
+{
+    if (!head || list_empty(head))
         return 0;
 
-    // From last element to first element
-    struct list_head *cur = head->prev;
-    const element_t *cur_elem = list_entry(cur, element_t, list);
-    const char *min_val = cur_elem->value;  // keep the last element
-
-    cur = cur->prev;
-    while (cur != head) {
-        // Avoid the last element is removed
-        struct list_head *temp = cur->prev;
-        element_t *entry = list_entry(cur, element_t, list);
-        if (strcmp(entry->value, min_val) > 0) {
-            cur->prev->next = cur->next;
-            cur->next->prev = cur->prev;
-            free(entry->value);
-            free(entry);
+    LIST_HEAD(left);
+    struct list_head *slow = head->next;
+    for (const struct list_head *fast = slow->next;
+         fast != head && fast->next != head; fast = fast->next->next) {
+        slow = slow->next;
+    }
+    list_cut_position(&left, head, slow);
+
+    element_sort(&descend, &left);
+    element_sort(&descend, head);
+    left.prev->next = NULL;  // break the circular lists
+    head->prev->next = NULL;
+
+    return restore_circular(head, merge_unique(left.next, head->next, descend));
+}
+
+
+static inline int order_cmp(const char *a, const char *b, bool descend)
+{
+    int cmp = strcmp(a, b);
+    return descend ? -cmp : cmp;
+}
+
+/* Median of the first, middle and last strings of a queue of @n elements */
+static const char *median_of_three(struct list_head *head, int n, bool descend)
+{
+    struct list_head *mid = head->next;
+    for (int i = 0; i < n / 2; i++)
+        mid = mid->next;
+
+    const char *a = list_first_entry(head, element_t, list)->value;
+    const char *b = list_entry(mid, element_t, list)->value;
+    const char *c = list_last_entry(head, element_t, list)->value;
+
+    if (order_cmp(a, b, descend) > 0) {
+        const char *tmp = a;
+        a = b;
+        b = tmp;
+    }
+    if (order_cmp(b, c, descend) <= 0)
+        return b;
+    return order_cmp(a, c, descend) > 0 ? a : c;
+}
+
+/* Find the element at a position of the sorted queue */
+element_t *q_nth_element(struct list_head *head, int k, bool descend)
+{
+    if (!head || k < 0)
+        return NULL;
+
+    int n = q_size(head);
+    if (k >= n)
+        return NULL;
+
+    /* The remaining range is kept in @head, the elements known to be sorted
+     * before or after it are kept aside in order.
+     */
+    LIST_HEAD(before);
+    LIST_HEAD(after);
+    element_t *nth = NULL;
+    while (!nth) {
+        LIST_HEAD(less);
+        LIST_HEAD(greater);
+        const char *pivot = median_of_three(head, n, descend);
+        int nless = 0, ngreater = 0;
+
+        element_t *entry, *safe;
+        list_for_each_entry_safe(entry, safe, head, list) {
+            int cmp = order_cmp(entry->value, pivot, descend);
+            if (cmp < 0) {
+                list_move_tail(&entry->list, &less);
+                nless++;
+            } else if (cmp > 0) {
+                list_move_tail(&entry->list, &greater);
+                ngreater++;
+            }
+        }
+
+        /* Only the elements equal to the pivot are left in @head */
+        int nequal = n - nless - ngreater;
+        if (k < nless) {
+            list_splice(&greater, &after);
+            list_splice_init(head, &after);
+            list_splice(&less, head);
+            n = nless;
+        } else if (k < nless + nequal) {
+            struct list_head *node = head->next;
+            for (k -= nless; k > 0; k--)
+                node = node->next;
+            nth = list_entry(node, element_t, list);
+            list_splice(&less, head);
+            list_splice_tail(&greater, head);
         } else {
-            min_val = entry->value;
+            list_splice_tail(&less, &before);
+            list_splice_tail_init(head, &before);
+            list_splice(&greater, head);
+            k -= nless + nequal;
+            n = ngreater;
         }
-        cur = temp;
     }
-    return q_size(head);
+    list_splice(&before, head);
+    list_splice_tail(&after, head);
+
+    return nth;
 }
 
-/* Remove every node which has a node with a strictly greater value anywhere to
- * the right side of it */
-int q_descend(struct list_head *head)
+/* Split a queue into two queues around a pivot */
+int q_partition(struct list_head *head,
+                struct list_head *rest,
+                const char *pivot,
+                bool descend)
 {
-    // https://leetcode.com/problems/remove-nodes-from-linked-list/
-    if (!head || head->next == head)
+    if (!head || !rest || !pivot)
         return 0;
 
-    // From last element to first element
-    struct list_head *cur = head->prev;
-    const element_t *cur_elem = list_entry(cur, element_t, list);
-    const char *max_val = cur_elem->value;  // keep the last element
-
-
-    cur = cur->prev;
-    while (cur != head) {
-        // Avoid the last element is removed
-        struct list_head *temp = cur->prev;
-        element_t *entry = list_entry(cur, element_t, list);
-        if (strcmp(entry->value, max_val) < 0) {
-            cur->prev->next = cur->next;
-            cur->next->prev = cur->prev;
-            free(entry->value);
-            free(entry);
-        } else {
-            max_val = entry->value;
+    int moved = 0;
+    element_t *entry, *safe;
+    list_for_each_entry_safe(entry, safe, head, list) {
+        if (order_cmp(entry->value, pivot, descend) >= 0) {
+            list_move_tail(&entry->list, rest);
+            moved++;
         }
-        cur = temp;
     }
-    return q_size(head);
+    return moved;
+}
+
+/* Keep the elements accepted by a predicate visiting the queue backward */
+int q_filter(struct list_head *head, q_predicate_t keep, void *priv)
+{
+    if (!head || !keep)
+        return 0;
+
+    LIST_HEAD(removed);
+    int count = 0;
+    struct list_head *cur = head->prev, *prev;
+    for (; cur != head; cur = prev) {
+        prev = cur->prev;
+        if (keep(list_entry(cur, element_t, list), priv))
+            count++;
+        else
+            list_move(cur, &removed);
+    }
+    reclaim_list(&removed);
+    return count;
+}
+
+/* Keep an element unless a strictly less (or greater) one was seen on its
+ * right side. @priv points to the last kept string, NULL for none.
+ */
+static bool keep_ascend(const element_t *e, void *priv)
+{
+    const char **bound = priv;
+    if (*bound && strcmp(e->value, *bound) > 0)
+        return false;
+    *bound = e->value;
+    return true;
+}
+
+static bool keep_descend(const element_t *e, void *priv)
+{
+    const char **bound = priv;
+    if (*bound && strcmp(e->value, *bound) < 0)
+        return false;
+    *bound = e->value;
+    return true;
+}
+
+/* Remove every node which has a node with a strictly less value anywhere to
+ * the right side of it */
+int q_ascend(struct list_head *head)
+{
+    // https://leetcode.com/problems/remove-nodes-from-linked-list/
+    const char *min_val = NULL;
+    return q_filter(head, keep_ascend, &min_val);
+}
+
+/* Remove every node which has a node with a strictly greater value anywhere to
+ * the right side of it */
+int q_descend(struct list_head *head)
+{
+    // https://leetcode.com/problems/remove-nodes-from-linked-list/
+    const char *max_val = NULL;
+    return q_filter(head, keep_descend, &max_val);
 }
 
 int q_merge(struct list_head *head, bool descend)
@@ -346,14 +627,17 @@ int q_merge(struct list_head *head, bool descend)
     struct list_head merged;
     INIT_LIST_HEAD(&merged);
 
+    STATS_INC(merges);
     while (1) {
         queue_contex_t *entry, *best_queue = NULL;
         struct list_head *best_node = NULL;
 
         list_for_each_entry(entry, head, chain) {
+            STATS_INC(hops);
             if (list_empty(entry->q))
                 continue;
 
+            STATS_ADD(compares, !!best_node);
             if (!best_node) {
                 best_node = entry->q->next;
                 best_queue = entry;
@@ -385,4 +669,365 @@ int q_merge(struct list_head *head, bool descend)
     first_entry->size = q_size(first_entry->q);
 
     return first_entry->size;
-}
\ No newline at end of file
+}
+
+/* Merge all the queues into one sorted queue without duplicate strings */
+int q_merge_unique(struct list_head *head, bool descend)
+{
+    if (!head || list_empty(head))
+        return 0;
+
+    /* Detach the content of every queue as a NULL-terminated list kept in the
+     * next pointer of its head.
+     */
+    int k = 0;
+    queue_contex_t *entry;
+    list_for_each_entry(entry, head, chain) {
+        if (list_empty(entry->q))
+            entry->q->next = NULL;
+        else
+            entry->q->prev->next = NULL;
+        entry->size = 0;
+        k++;
+    }
+
+    /* Merge in rounds of pairs of queues that are step apart in the chain.
+     * Only the very last merge drops duplicate runs.
+     */
+    for (int step = 1; step < k || step == 1; step <<= 1) {
+        struct list_head *a = head->next;
+        for (int i = 0; i + step < k || (k == 1 && i == 0); i += step << 1) {
+            struct list_head *b = a;
+            for (int j = 0; j < step && b->next != head; j++)
+                b = b->next;
+
+            struct list_head *qa = list_entry(a, queue_contex_t, chain)->q;
+            struct list_head *qb =
+                k == 1 ? NULL : list_entry(b, queue_contex_t, chain)->q;
+            struct list_head *right = qb ? qb->next : NULL;
+            if (qb)
+                qb->next = NULL;
+            if (step << 1 >= k)
+                qa->next = merge_unique(qa->next, right, descend);
+            else
+                qa->next = merge(qa->next, right, descend);
+
+            for (int j = 0; j < step << 1 && a->next != head; j++)
+                a = a->next;
+        }
+    }
+
+    list_for_each_entry(entry, head, chain) {
+        if (entry->q->next)
+            entry->size = restore_circular(entry->q, entry->q->next);
+        else
+            INIT_LIST_HEAD(entry->q);
+    }
+
+    return list_entry(head->next, queue_contex_t, chain)->size;
+}
+
+/* FNV-1a hash of a string */
+static uint32_t hash_value(const char *s)
+{
+    uint32_t hash = 2166136261u;
+    while (*s) {
+        hash ^= (unsigned char) *s++;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+/* Next queue of the chain, wrapping around over the header of the chain */
+static inline queue_contex_t *next_queue(struct list_head *head,
+                                         queue_contex_t *ctx)
+{
+    struct list_head *next = ctx->chain.next;
+    return list_entry(next == head ? head->next : next, queue_contex_t, chain);
+}
+
+/* Distribute the first queue over all the queues of the chain */
+bool q_scatter(struct list_head *head, scatter_mode_t mode)
+{
+    if (!head || list_empty(head))
+        return false;
+
+    int k = q_size(head);
+    queue_contex_t **shards = NULL;
+    if (mode == SCATTER_HASH) {
+        shards = malloc(sizeof(queue_contex_t *) * k);
+        if (!shards)
+            return false;
+        int i = 0;
+        queue_contex_t *ctx;
+        list_for_each_entry(ctx, head, chain)
+            shards[i++] = ctx;
+    }
+
+    queue_contex_t *first = list_first_entry(head, queue_contex_t, chain);
+    LIST_HEAD(src);
+    list_splice_init(first->q, &src);
+    first->size = 0;
+
+    queue_contex_t *ctx = first;
+
+    switch (mode) {
+    case SCATTER_ROUND_ROBIN:
+        while (!list_empty(&src)) {
+            list_move_tail(src.next, ctx->q);
+            ctx->size++;
+            ctx = next_queue(head, ctx);
+        }
+        break;
+    case SCATTER_HASH: {
+        element_t *entry, *safe;
+        list_for_each_entry_safe(entry, safe, &src, list) {
+            ctx = shards[hash_value(entry->value) % k];
+            list_move_tail(&entry->list, ctx->q);
+            ctx->size++;
+        }
+        break;
+    }
+    case SCATTER_RANGE: {
+        int n = q_size(&src);
+        for (int i = 0; i < k; i++, ctx = next_queue(head, ctx)) {
+            int len = n / k + (i < n % k);
+            if (!len)
+                break;
+            struct list_head *last = &src;
+            for (int j = 0; j < len; j++)
+                last = last->next;
+            LIST_HEAD(range);
+            list_cut_position(&range, &src, last);
+            list_splice_tail(&range, ctx->q);
+            ctx->size += len;
+        }
+        break;
+    }
+    }
+    free(shards);
+    return true;
+}
+
+/* Concatenate all the queues of the chain into the first one */
+int q_gather(struct list_head *head)
+{
+    if (!head || list_empty(head))
+        return 0;
+
+    queue_contex_t *first = list_first_entry(head, queue_contex_t, chain);
+    for (struct list_head *node = first->chain.next; node != head;
+         node = node->next) {
+        queue_contex_t *ctx = list_entry(node, queue_contex_t, chain);
+        list_splice_tail_init(ctx->q, first->q);
+        first->size += ctx->size;
+        ctx->size = 0;
+    }
+    return first->size;
+}
+
+/* Relocate the elements of the queue in list order */
+bool q_compact(struct list_head *head)
+{
+    if (!head)
+        return false;
+
+    /* Carve the copies from one arena rather than from wherever the heap has
+     * holes left, which after churn are scattered as much as the old nodes.
+     */
+    size_t n = 0, bytes = 0;
+    const element_t *entry;
+    list_for_each_entry(entry, head, list) {
+        bytes += sizeof(element_t) + strlen(entry->value) + 1;
+        n++;
+    }
+    if (!n)
+        return true;
+    test_arena_t *arena = test_arena_new(2 * n, bytes);
+    if (!arena)
+        return false;
+
+    /* The copies are only linked to the queue once all of them are made */
+    exception_hold();
+    LIST_HEAD(fresh);
+    struct list_head *ahead;
+    list_for_each_entry_prefetch(entry, ahead, head, list, value) {
+        element_t *copy = test_arena_malloc(arena, sizeof(element_t));
+        if (copy && !(copy->value = test_arena_strdup(arena, entry->value))) {
+            free(copy);
+            copy = NULL;
+        }
+        if (!copy) {
+            reclaim_list(&fresh);
+            test_arena_close(arena);
+            exception_release();
+            return false;
+        }
+        list_add_tail(&copy->list, &fresh);
+    }
+    test_arena_close(arena);
+
+    LIST_HEAD(old);
+    list_splice_init(head, &old);
+    list_splice(&fresh, head);
+    exception_release();
+    reclaim_list(&old);
+    return true;
+}
+
+/* Insert every line of a file at the tail of queue */
+int q_load_file(struct list_head *head, const char *path)
+{
+    if (!head || !path)
+        return -1;
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return -1;
+    struct stat st;
+    if (fstat(fd, &st)) {
+        close(fd);
+        return -1;
+    }
+    if (!st.st_size) {
+        close(fd);
+        return 0;
+    }
+    const char *data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED)
+        return -1;
+    madvise((void *) data, st.st_size, MADV_SEQUENTIAL);
+
+    /* Build the elements aside, so that a failure leaves the queue as is */
+    LIST_HEAD(fresh);
+    int count = 0;
+    for (const char *p = data, *end = data + st.st_size; p < end; count++) {
+        const char *eol = memchr(p, '\n', end - p);
+        size_t len = (eol ? eol : end) - p;
+
+        element_t *e = malloc(sizeof(element_t));
+        if (e && !(e->value = malloc(len + 1))) {
+            free(e);
+            e = NULL;
+        }
+        if (!e) {
+            reclaim_list(&fresh);
+            munmap((void *) data, st.st_size);
+            return -1;
+        }
+        memcpy(e->value, p, len);
+        e->value[len] = '\0';
+        list_add_tail(&e->list, &fresh);
+        p += len + 1;
+    }
+    munmap((void *) data, st.st_size);
+
+    list_splice_tail(&fresh, head);
+    return count;
+}
+
+/* Buffering of q_dump_file(): strings up to DUMP_COPY bytes are copied into
+ * the buffer, which costs less than a buffer of their own in writev(), while
+ * longer ones are written from the element.
+ */
+#define DUMP_BUF 65536
+#define DUMP_COPY 256
+#define DUMP_IOV 64
+
+typedef struct {
+    int fd, cnt;
+    size_t used, mark; /* bytes in buf, start of those not in iov yet */
+    struct iovec iov[DUMP_IOV];
+    char buf[DUMP_BUF];
+} dump_t;
+
+/* Write a batch of buffers, resuming after short writes */
+static bool write_all(int fd, struct iovec *iov, int cnt)
+{
+    while (cnt) {
+        ssize_t n = writev(fd, iov, cnt);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            return false;
+        }
+        for (; cnt && (size_t) n >= iov->iov_len; iov++, cnt--)
+            n -= iov->iov_len;
+        if (cnt) {
+            iov->iov_base = (char *) iov->iov_base + n;
+            iov->iov_len -= n;
+        }
+    }
+    return true;
+}
+
+/* Close the part of the buffer filled since the last string written apart */
+static void dump_cut(dump_t *d)
+{
+    if (d->used > d->mark) {
+        d->iov[d->cnt].iov_base = d->buf + d->mark;
+        d->iov[d->cnt++].iov_len = d->used - d->mark;
+        d->mark = d->used;
+    }
+}
+
+static bool dump_flush(dump_t *d)
+{
+    dump_cut(d);
+    bool ok = write_all(d->fd, d->iov, d->cnt);
+    d->cnt = 0;
+    d->used = d->mark = 0;
+    return ok;
+}
+
+static bool dump_string(dump_t *d, char *s)
+{
+    size_t len = strlen(s);
+    bool copy = len <= DUMP_COPY;
+
+    /* Keep room for the copy or the newline, and for the string and two
+     * parts of the buffer in iov
+     */
+    if ((DUMP_BUF - d->used < (copy ? len + 1 : 1) || d->cnt > DUMP_IOV - 3) &&
+        !dump_flush(d))
+        return false;
+
+    if (copy) {
+        memcpy(d->buf + d->used, s, len);
+        d->used += len;
+    } else {
+        dump_cut(d);
+        d->iov[d->cnt].iov_base = s;
+        d->iov[d->cnt++].iov_len = len;
+    }
+    d->buf[d->used++] = '\n';
+    return true;
+}
+
+/* Write every string of queue to a file, one per line */
+int q_dump_file(struct list_head *head, const char *path)
+{
+    if (!head || !path)
+        return -1;
+
+    dump_t d = {.fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644)};
+    if (d.fd < 0)
+        return -1;
+
+    int count = 0;
+    bool ok = true;
+    const element_t *entry;
+    struct list_head *ahead;
+    list_for_each_entry_prefetch(entry, ahead, head, list, value) {
+        if (!(ok = dump_string(&d, entry->value)))
+            break;
+        count++;
+    }
+    if (ok)
+        ok = dump_flush(&d);
+
+    if (close(d.fd))
+        ok = false;
+    return ok ? count : -1;
+}
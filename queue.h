@@ -39,6 +39,20 @@ typedef struct {
     int id;
 } queue_contex_t;
 
+/**
+ * scatter_mode_t - How q_scatter() assigns elements to the queues of a chain
+ * @SCATTER_ROUND_ROBIN: the i-th element goes to the (i mod k)-th queue
+ * @SCATTER_HASH: elements go to the queue selected by the hash of their value,
+ *                so equal strings end up in the same queue
+ * @SCATTER_RANGE: each queue receives one contiguous range, the sizes of the
+ *                 ranges differ by at most one
+ */
+typedef enum {
+    SCATTER_ROUND_ROBIN,
+    SCATTER_HASH,
+    SCATTER_RANGE,
+} scatter_mode_t;
+
 /* Operations on queue */
 
 /**
@@ -200,6 +214,83 @@ void q_reverseK(struct list_head *head, int k);
  */
 void q_sort(struct list_head *head, bool descend);
 
+/**
+ * q_sort_unique() - Sort elements of queue and delete all nodes that have
+ * duplicate string
+ * @head: header of queue
+ * @descend: whether or not to sort in descending order
+ *
+ * Produces the same queue as q_sort() followed by q_delete_dup(), but the
+ * duplicate runs are dropped during the final merge pass, so the data is only
+ * traversed once after sorting the two halves.
+ *
+ * Return: the number of elements in queue after performing operation
+ */
+int q_sort_unique(struct list_head *head, bool descend);
+
+/**
+ * q_nth_element() - Find the element at a position of the sorted queue
+ * @head: header of queue
+ * @k: zero-based position in the sorted queue
+ * @descend: whether or not the queue would be sorted in descending order
+ *
+ * Quickselect with a median-of-three pivot, where each round relinks the
+ * nodes of the remaining range into three lists. No allocation is performed
+ * and the expected running time is linear.
+ *
+ * The queue is left partially sorted: no element before the returned one would
+ * be sorted after it, and no element after it would be sorted before it. Every
+ * partition is stable, so equal strings keep their relative order and the
+ * returned node is the one q_sort() would place at position @k.
+ *
+ * Return: the element, NULL if queue is NULL or @k is out of range
+ */
+element_t *q_nth_element(struct list_head *head, int k, bool descend);
+
+/**
+ * q_partition() - Split a queue into two queues around a pivot
+ * @head: header of queue
+ * @rest: header of the queue receiving the other elements
+ * @pivot: string the elements are compared against
+ * @descend: whether or not the queues are ordered in descending order
+ *
+ * Elements that would be sorted before @pivot stay in @head; the others are
+ * appended to @rest. Both queues keep the relative order of their elements.
+ * Nodes are only relinked, no allocation is performed.
+ *
+ * Return: the number of elements moved to @rest
+ */
+int q_partition(struct list_head *head,
+                struct list_head *rest,
+                const char *pivot,
+                bool descend);
+
+/**
+ * q_predicate_t - Predicate deciding whether q_filter() keeps an element
+ * @e: the element being visited
+ * @priv: private data passed to q_filter()
+ *
+ * Return: true to keep the element, false to delete it
+ */
+typedef bool (*q_predicate_t)(const element_t *e, void *priv);
+
+/**
+ * q_filter() - Delete every element rejected by a predicate
+ * @head: header of queue
+ * @keep: predicate called once for every element
+ * @priv: private data passed to @keep
+ *
+ * Elements are visited from the tail to the head in a single pass, so a
+ * predicate keeping state in @priv sees every element after all elements on
+ * its right side, which is what monotonic filters such as q_ascend() need.
+ * Rejected elements are unlinked into a detached list and released in one
+ * batch once the pass is over, so @keep may still refer to them. The batch
+ * goes to the reclaimer thread when it is running.
+ *
+ * Return: the number of elements in queue after performing operation
+ */
+int q_filter(struct list_head *head, q_predicate_t keep, void *priv);
+
 /**
  * q_ascend() - Delete every node which has a node with a strictly less
  * value anywhere to the right side of it.
@@ -250,4 +341,93 @@ int q_descend(struct list_head *head);
  */
 int q_merge(struct list_head *head, bool descend);
 
+/**
+ * q_merge_unique() - Merge all the queues into one sorted queue and delete all
+ * nodes that have duplicate string
+ * @head: header of chain
+ * @descend: whether to merge queues sorted in descending order
+ *
+ * Produces the same queue as q_merge() followed by q_delete_dup(), with the
+ * same requirements on the chain. The queues are merged pairwise and duplicate
+ * runs are dropped during the final merge pass.
+ *
+ * Return: the number of elements in queue after merging
+ */
+int q_merge_unique(struct list_head *head, bool descend);
+
+/**
+ * q_scatter() - Distribute the first queue over all the queues of the chain
+ * @head: header of chain
+ * @mode: how elements are assigned to the queues
+ *
+ * The elements of the first queue are appended to the k queues of the chain,
+ * the first one included, keeping their relative order within each queue.
+ * Nodes are only relinked and the size of every queue is updated, so the
+ * whole operation is O(n + k). Only SCATTER_HASH allocates, an array of k
+ * pointers.
+ *
+ * Return: true for success, false if chain is NULL or empty, or allocation
+ * failed
+ */
+bool q_scatter(struct list_head *head, scatter_mode_t mode);
+
+/**
+ * q_gather() - Concatenate all the queues of the chain into the first one
+ * @head: header of chain
+ *
+ * The queues are spliced in chain order and left empty, which is O(k). The
+ * sizes stored in the chain must be accurate.
+ *
+ * Return: the number of elements in the first queue after gathering
+ */
+int q_gather(struct list_head *head);
+
+/**
+ * q_compact() - Relocate the elements of the queue in list order
+ * @head: header of queue
+ *
+ * Long runs of insertions, removals and sorts leave consecutive elements far
+ * apart in memory, so every step of a traversal misses the cache. Every
+ * element and its string are copied in list order into blocks carved from one
+ * arena, so that they stay adjacent however scattered the holes of the heap
+ * are, then the old elements are released. The blocks are still released one
+ * by one, and the arena goes back along with the last of them.
+ *
+ * Return: true for success, false if queue is NULL or allocation failed, in
+ * which case the queue is left unchanged
+ */
+bool q_compact(struct list_head *head);
+
+/**
+ * q_load_file() - Insert every line of a file at the tail of queue
+ * @head: header of queue
+ * @path: name of the file, holding one string per line
+ *
+ * The file is mapped rather than read, and lines are found with memchr(), so
+ * each string is copied once, straight from the page cache into its element.
+ * Line terminators are not part of the strings, and a last line lacking one
+ * still counts.
+ *
+ * Return: the number of inserted elements, -1 if queue is NULL, the file
+ * cannot be mapped or allocation failed, in which case the queue is left
+ * unchanged
+ */
+int q_load_file(struct list_head *head, const char *path);
+
+/**
+ * q_dump_file() - Write every string of queue to a file, one per line
+ * @head: header of queue
+ * @path: name of the file, created or truncated
+ *
+ * Lines are written in batches by writev(), without formatting them: short
+ * strings are gathered into a buffer, which is cheaper than a buffer of their
+ * own in the batch, and long ones are handed over straight from the elements.
+ * The file reads back with q_load_file(), as long as no string holds a
+ * newline.
+ *
+ * Return: the number of written strings, -1 if queue is NULL or the file
+ * cannot be written
+ */
+int q_dump_file(struct list_head *head, const char *path);
+
 #endif /* LAB0_QUEUE_H */
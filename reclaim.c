@@ -0,0 +1,122 @@
+#include <pthread.h>
+#include <signal.h>
+#include <stddef.h>
+
+/* The reclaimer frees blocks on behalf of the tested program */
+#define INTERNAL 1
+#include "harness.h"
+
+#include "queue.h"
+#include "reclaim.h"
+
+/* Each pending batch is a NULL-terminated chain of nodes. The prev pointer of
+ * its first node links to the next pending batch.
+ */
+static struct list_head *pending = NULL;
+static bool running = false, busy = false, stopping = false;
+
+static pthread_t reclaimer;
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t work = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t idle = PTHREAD_COND_INITIALIZER;
+
+static void release_chain(struct list_head *node)
+{
+    while (node) {
+        struct list_head *next = node->next;
+        if (next)
+            list_prefetch(list_entry(next, element_t, list)->value);
+        q_release_element(list_entry(node, element_t, list));
+        node = next;
+    }
+}
+
+static void *reclaim_loop(void *arg)
+{
+    (void) arg;
+    set_reclaimer_thread();
+
+    pthread_mutex_lock(&lock);
+    while (1) {
+        while (!pending && !stopping)
+            pthread_cond_wait(&work, &lock);
+        if (!pending)
+            break;
+
+        struct list_head *batch = pending;
+        pending = NULL;
+        busy = true;
+        pthread_mutex_unlock(&lock);
+
+        while (batch) {
+            struct list_head *next = batch->prev;
+            release_chain(batch);
+            batch = next;
+        }
+
+        pthread_mutex_lock(&lock);
+        busy = false;
+        pthread_cond_broadcast(&idle);
+    }
+    pthread_mutex_unlock(&lock);
+    return NULL;
+}
+
+bool reclaim_start()
+{
+    if (running)
+        return true;
+
+    /* Keep the signals used for exceptions on the main thread */
+    sigset_t all, old;
+    sigfillset(&all);
+    pthread_sigmask(SIG_SETMASK, &all, &old);
+    stopping = false;
+    running = !pthread_create(&reclaimer, NULL, reclaim_loop, NULL);
+    pthread_sigmask(SIG_SETMASK, &old, NULL);
+
+    return running;
+}
+
+void reclaim_stop()
+{
+    if (!running)
+        return;
+
+    pthread_mutex_lock(&lock);
+    stopping = true;
+    pthread_cond_signal(&work);
+    pthread_mutex_unlock(&lock);
+
+    pthread_join(reclaimer, NULL);
+    running = false;
+}
+
+void reclaim_wait()
+{
+    pthread_mutex_lock(&lock);
+    while (pending || busy)
+        pthread_cond_wait(&idle, &lock);
+    pthread_mutex_unlock(&lock);
+}
+
+void reclaim_list(struct list_head *list)
+{
+    if (!list || list_empty(list))
+        return;
+
+    struct list_head *first = list->next;
+    list->prev->next = NULL;
+    INIT_LIST_HEAD(list);
+
+    if (!running) {
+        release_chain(first);
+        return;
+    }
+
+    pthread_mutex_lock(&lock);
+    first->prev = pending;
+    pending = first;
+    pthread_cond_signal(&work);
+    pthread_mutex_unlock(&lock);
+}
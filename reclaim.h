@@ -0,0 +1,45 @@
+#ifndef LAB0_RECLAIM_H
+#define LAB0_RECLAIM_H
+
+/* This program implements deferred reclamation of queue elements.
+ *
+ * Elements deleted by a queue operation are handed over as a whole list in
+ * O(1), and a background thread releases them off the critical path. When the
+ * reclaimer is not running, the elements are released immediately.
+ */
+
+#include <stdbool.h>
+
+#include "list.h"
+
+/**
+ * reclaim_start() - Start the reclaimer thread
+ *
+ * The harness must be in concurrent mode while the reclaimer is running.
+ *
+ * Return: true for success or if it is already running, false otherwise
+ */
+bool reclaim_start();
+
+/**
+ * reclaim_stop() - Release every pending element and stop the reclaimer thread
+ */
+void reclaim_stop();
+
+/**
+ * reclaim_wait() - Wait until every element handed over so far is released
+ *
+ * Call it before reading allocation_check(), which counts pending elements
+ * as still allocated.
+ */
+void reclaim_wait();
+
+/**
+ * reclaim_list() - Release all the elements of a list
+ * @list: header of a list of element_t, which is left empty
+ *
+ * The elements are only detached here in O(1) if the reclaimer is running.
+ */
+void reclaim_list(struct list_head *list);
+
+#endif /* LAB0_RECLAIM_H */
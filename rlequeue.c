@@ -0,0 +1,248 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "rlequeue.h"
+
+static inline void rq_release_run(rle_element_t *run)
+{
+    test_free(run->value);
+    test_free(run);
+}
+
+/* Allocate a run of @count copies of @s and link it after @prev */
+static bool rq_add_run(struct list_head *prev, const char *s, size_t count)
+{
+    rle_element_t *run = malloc(sizeof(rle_element_t));
+    if (!run)
+        return false;
+
+    run->value = strdup(s);
+    if (!run->value) {
+        free(run);
+        return false;
+    }
+    run->count = count;
+    list_add(&run->list, prev);
+
+    return true;
+}
+
+/* Fold every run equal to the one at @node into it, restoring the invariant
+ * that adjacent runs hold different strings.
+ */
+static void rq_coalesce(struct list_head *head, struct list_head *node)
+{
+    rle_element_t *run = list_entry(node, rle_element_t, list);
+
+    while (node->next != head) {
+        rle_element_t *next = list_entry(node->next, rle_element_t, list);
+        if (strcmp(run->value, next->value))
+            break;
+        run->count += next->count;
+        list_del(&next->list);
+        rq_release_run(next);
+    }
+}
+
+/* Create an empty queue */
+struct list_head *rq_new()
+{
+    struct list_head *head = malloc(sizeof(struct list_head));
+    if (head)
+        INIT_LIST_HEAD(head);
+    return head;
+}
+
+/* Free all storage used by queue */
+void rq_free(struct list_head *head)
+{
+    if (!head)
+        return;
+    rle_element_t *run, *safe;
+    list_for_each_entry_safe(run, safe, head, list)
+        rq_release_run(run);
+    free(head);
+}
+
+/* Insert copies of a string at head of queue */
+bool rq_insert_head(struct list_head *head, const char *s, size_t count)
+{
+    if (!head || !s || !count)
+        return false;
+
+    if (!list_empty(head)) {
+        rle_element_t *first = list_first_entry(head, rle_element_t, list);
+        if (!strcmp(first->value, s)) {
+            first->count += count;
+            return true;
+        }
+    }
+    return rq_add_run(head, s, count);
+}
+
+/* Insert copies of a string at tail of queue */
+bool rq_insert_tail(struct list_head *head, const char *s, size_t count)
+{
+    if (!head || !s || !count)
+        return false;
+
+    if (!list_empty(head)) {
+        rle_element_t *last = list_last_entry(head, rle_element_t, list);
+        if (!strcmp(last->value, s)) {
+            last->count += count;
+            return true;
+        }
+    }
+    return rq_add_run(head->prev, s, count);
+}
+
+/* Take one element off the given run */
+static bool rq_remove(struct list_head *node, char *sp, size_t bufsize)
+{
+    rle_element_t *run = list_entry(node, rle_element_t, list);
+
+    if (sp && bufsize > 0) {
+        strncpy(sp, run->value, bufsize - 1);
+        sp[bufsize - 1] = '\0';
+    }
+
+    if (--run->count == 0) {
+        list_del(&run->list);
+        rq_release_run(run);
+    }
+    return true;
+}
+
+/* Remove an element from head of queue */
+bool rq_remove_head(struct list_head *head, char *sp, size_t bufsize)
+{
+    if (!head || list_empty(head))
+        return false;
+    return rq_remove(head->next, sp, bufsize);
+}
+
+/* Remove an element from tail of queue */
+bool rq_remove_tail(struct list_head *head, char *sp, size_t bufsize)
+{
+    if (!head || list_empty(head))
+        return false;
+    return rq_remove(head->prev, sp, bufsize);
+}
+
+/* Return number of elements in queue */
+size_t rq_size(struct list_head *head)
+{
+    if (!head)
+        return 0;
+
+    size_t count = 0;
+    const rle_element_t *run;
+    list_for_each_entry(run, head, list)
+        count += run->count;
+    return count;
+}
+
+/* Delete all elements that have duplicate string */
+bool rq_delete_dup(struct list_head *head)
+{
+    if (!head || list_empty(head))
+        return false;
+
+    rle_element_t *run, *safe;
+    list_for_each_entry_safe(run, safe, head, list) {
+        if (run->count > 1) {
+            list_del(&run->list);
+            rq_release_run(run);
+        }
+    }
+
+    /* The runs around a dropped one may hold the same string */
+    struct list_head *node;
+    list_for_each(node, head)
+        rq_coalesce(head, node);
+
+    return true;
+}
+
+/* Reverse elements in queue */
+void rq_reverse(struct list_head *head)
+{
+    if (!head || list_empty(head))
+        return;
+
+    struct list_head *current = head;
+    do {
+        struct list_head *temp = current->next;
+        current->next = current->prev;
+        current->prev = temp;
+        current = temp;
+    } while (current != head);
+}
+
+static struct list_head *rq_merge(struct list_head *left,
+                                  struct list_head *right,
+                                  bool descend)
+{
+    struct list_head merged;
+    struct list_head *cur = &merged;
+
+    while (left && right) {
+        int cmp = strcmp(list_entry(left, rle_element_t, list)->value,
+                         list_entry(right, rle_element_t, list)->value);
+        if (descend)
+            cmp = -cmp;
+
+        if (cmp <= 0) {
+            cur->next = left;
+            left = left->next;
+        } else {
+            cur->next = right;
+            right = right->next;
+        }
+        cur = cur->next;
+    }
+    cur->next = left ? left : right;
+
+    return merged.next;
+}
+
+static struct list_head *rq_merge_sort(struct list_head *head, bool descend)
+{
+    if (!head || !head->next)
+        return head;
+
+    struct list_head *slow = head, *mid;
+    for (const struct list_head *fast = head->next; fast && fast->next;
+         fast = fast->next->next) {
+        slow = slow->next;
+    }
+    mid = slow->next;
+    slow->next = NULL;
+
+    struct list_head *left = rq_merge_sort(head, descend);
+    struct list_head *right = rq_merge_sort(mid, descend);
+
+    return rq_merge(left, right, descend);
+}
+
+/* Sort elements of queue in ascending/descending order */
+void rq_sort(struct list_head *head, bool descend)
+{
+    if (!head || list_empty(head) || list_is_singular(head))
+        return;
+
+    head->prev->next = NULL;
+    head->next = rq_merge_sort(head->next, descend);
+    struct list_head *cur = head;
+    while (cur->next) {
+        cur->next->prev = cur;
+        cur = cur->next;
+    }
+    cur->next = head;
+    head->prev = cur;
+
+    /* Equal runs are adjacent now, fold them together */
+    list_for_each(cur, head)
+        rq_coalesce(head, cur);
+}
@@ -0,0 +1,129 @@
+#ifndef LAB0_RLEQUEUE_H
+#define LAB0_RLEQUEUE_H
+
+/* This program implements a run-length encoded queue.
+ *
+ * Like the queue in queue.h, it uses a circular doubly-linked list, but each
+ * node stores a run of equal strings as a (value, count) pair. Adjacent runs
+ * never hold equal strings, so memory and time scale with the number of runs
+ * rather than with the number of elements.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "harness.h"
+#include "list.h"
+
+/**
+ * rle_element_t - Run of equal strings
+ * @value: pointer to array holding string
+ * @count: number of consecutive elements holding @value, at least 1
+ * @list: node of a doubly-linked list
+ *
+ * @value needs to be explicitly allocated and freed
+ */
+typedef struct {
+    char *value;
+    size_t count;
+    struct list_head list;
+} rle_element_t;
+
+/* Operations on run-length encoded queue */
+
+/**
+ * rq_new() - Create an empty run-length encoded queue
+ *
+ * Return: NULL for allocation failed
+ */
+struct list_head *rq_new();
+
+/**
+ * rq_free() - Free all storage used by queue, no effect if header is NULL
+ * @head: header of queue
+ */
+void rq_free(struct list_head *head);
+
+/**
+ * rq_insert_head() - Insert @count copies of a string at the head
+ * @head: header of queue
+ * @s: string would be inserted
+ * @count: number of copies, must be positive
+ *
+ * The first run is extended if it already holds @s; otherwise a new run is
+ * allocated and the string copied into it.
+ *
+ * Return: true for success, false for allocation failed or queue is NULL
+ */
+bool rq_insert_head(struct list_head *head, const char *s, size_t count);
+
+/**
+ * rq_insert_tail() - Insert @count copies of a string at the tail
+ * @head: header of queue
+ * @s: string would be inserted
+ * @count: number of copies, must be positive
+ *
+ * Return: true for success, false for allocation failed or queue is NULL
+ */
+bool rq_insert_tail(struct list_head *head, const char *s, size_t count);
+
+/**
+ * rq_remove_head() - Remove one element from head of queue
+ * @head: header of queue
+ * @sp: output buffer where the removed string is copied
+ * @bufsize: size of the string
+ *
+ * The first run is decremented, and released once it becomes empty.
+ *
+ * Return: true for success, false if queue is NULL or empty.
+ */
+bool rq_remove_head(struct list_head *head, char *sp, size_t bufsize);
+
+/**
+ * rq_remove_tail() - Remove one element from tail of queue
+ * @head: header of queue
+ * @sp: output buffer where the removed string is copied
+ * @bufsize: size of the string
+ *
+ * Return: true for success, false if queue is NULL or empty.
+ */
+bool rq_remove_tail(struct list_head *head, char *sp, size_t bufsize);
+
+/**
+ * rq_size() - Get the number of elements in the queue
+ * @head: header of queue
+ *
+ * Return: the sum of all run lengths, zero if queue is NULL or empty
+ */
+size_t rq_size(struct list_head *head);
+
+/**
+ * rq_delete_dup() - Delete all elements that have a duplicate neighbour
+ * @head: header of queue
+ *
+ * Equivalent to q_delete_dup() on the decoded queue: every run longer than one
+ * element is dropped, and the runs left next to each other are coalesced.
+ *
+ * Return: true for success, false if list is NULL or empty.
+ */
+bool rq_delete_dup(struct list_head *head);
+
+/**
+ * rq_reverse() - Reverse elements in queue
+ * @head: header of queue
+ *
+ * Only the order of the runs is reversed. No allocation is performed.
+ */
+void rq_reverse(struct list_head *head);
+
+/**
+ * rq_sort() - Sort elements of queue in ascending/descending order
+ * @head: header of queue
+ * @descend: whether or not to sort in descending order
+ *
+ * Runs are sorted by value and runs with equal values are coalesced, which
+ * releases the redundant nodes.
+ */
+void rq_sort(struct list_head *head, bool descend);
+
+#endif /* LAB0_RLEQUEUE_H */
@@ -60,6 +60,33 @@ class Tracer:
 
     maxScores = [0, 5, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 5]
 
+    # Traces of the optional extensions, run with -x and scored apart from
+    # the traces above
+    extTraceDict = {
+        18: "trace-18-persistent",
+        19: "trace-19-arena",
+        20: "trace-20-pq",
+        21: "trace-21-unique",
+        22: "trace-22-nth",
+        23: "trace-23-scatter",
+        24: "trace-24-compact",
+        25: "trace-25-intern",
+        26: "trace-26-rle",
+        27: "trace-27-reclaim",
+        28: "trace-28-keys",
+        29: "trace-29-backends",
+        30: "trace-30-stats",
+        31: "trace-31-sortmem",
+        32: "trace-32-file",
+        33: "trace-33-session",
+        34: "trace-34-loadfile",
+        35: "trace-35-dump"
+    }
+
+    extTraceProbs = {tid: "Trace-%d" % tid for tid in extTraceDict}
+
+    extMaxScores = {tid: 5 for tid in extTraceDict}
+
     RED = '\033[91m'
     GREEN = '\033[92m'
     WHITE = '\033[0m'
@@ -69,13 +96,18 @@ class Tracer:
                  verbLevel=0,
                  autograde=False,
                  useValgrind=False,
-                 colored=False):
+                 colored=False,
+                 extensions=False):
         if qtest != "":
             self.qtest = qtest
         self.verbLevel = verbLevel
         self.autograde = autograde
         self.useValgrind = useValgrind
         self.colored = colored
+        if extensions:
+            self.traceDict = self.extTraceDict
+            self.traceProbs = self.extTraceProbs
+            self.maxScores = self.extMaxScores
 
     def printInColor(self, text, color):
         if self.colored == False:
@@ -146,12 +178,13 @@ class Tracer:
             sys.exit(1)
 
 def usage(name):
-    print("Usage: %s [-h] [-p PROG] [-t TID] [-v VLEVEL] [--valgrind] [-c]" % name)
+    print("Usage: %s [-h] [-p PROG] [-t TID] [-v VLEVEL] [--valgrind] [-c] [-x]" % name)
     print("  -h        Print this message")
     print("  -p PROG   Program to test")
     print("  -t TID    Trace ID to test")
     print("  -v VLEVEL Set verbosity level (0-3)")
     print("  -c Enable colored text")
+    print("  -x Run the traces of the optional extensions instead")
     sys.exit(0)
 
 
@@ -163,8 +196,9 @@ def run(name, args):
     autograde = False
     useValgrind = False
     colored = False
+    extensions = False
 
-    optlist, args = getopt.getopt(args, 'hp:t:v:A:c', ['valgrind'])
+    optlist, args = getopt.getopt(args, 'hp:t:v:A:cx', ['valgrind'])
     for (opt, val) in optlist:
         if opt == '-h':
             usage(name)
@@ -181,6 +215,8 @@ def run(name, args):
             useValgrind = True
         elif opt == '-c':
             colored = True
+        elif opt == '-x':
+            extensions = True
         else:
             print("Unrecognized option '%s'" % opt)
             usage(name)
@@ -190,7 +226,8 @@ def run(name, args):
                verbLevel=vlevel,
                autograde=autograde,
                useValgrind=useValgrind,
-               colored=colored)
+               colored=colored,
+               extensions=extensions)
     t.run(tid)
 
 
@@ -0,0 +1,142 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "squeue.h"
+
+#define sq_entry(h) container_of(h, squeue_t, head)
+
+/* Create an empty queue */
+struct list_head *sq_new()
+{
+    squeue_t *q = malloc(sizeof(squeue_t));
+    if (!q)
+        return NULL;
+
+    INIT_LIST_HEAD(&q->head);
+    INIT_STAILQ_HEAD(&q->list);
+    q->size = 0;
+    return &q->head;
+}
+
+/* Free all storage used by queue */
+void sq_free(struct list_head *head)
+{
+    if (!head)
+        return;
+
+    squeue_t *q = sq_entry(head);
+    struct slist_node *node;
+    while ((node = stailq_del_head(&q->list))) {
+        sq_element_t *e = container_of(node, sq_element_t, link);
+        free(e->value);
+        free(e);
+    }
+    free(q);
+}
+
+/* Allocate an element holding a copy of @s */
+static sq_element_t *sq_element_new(const char *s)
+{
+    sq_element_t *e = malloc(sizeof(sq_element_t));
+    if (!e)
+        return NULL;
+
+    e->value = strdup(s);
+    if (!e->value) {
+        free(e);
+        return NULL;
+    }
+    return e;
+}
+
+/* Insert an element at head of queue */
+bool sq_insert_head(struct list_head *head, const char *s)
+{
+    if (!head || !s)
+        return false;
+
+    squeue_t *q = sq_entry(head);
+    sq_element_t *e = sq_element_new(s);
+    if (!e)
+        return false;
+    stailq_add(&e->link, &q->list);
+    q->size++;
+    return true;
+}
+
+/* Insert an element at tail of queue */
+bool sq_insert_tail(struct list_head *head, const char *s)
+{
+    if (!head || !s)
+        return false;
+
+    squeue_t *q = sq_entry(head);
+    sq_element_t *e = sq_element_new(s);
+    if (!e)
+        return false;
+    stailq_add_tail(&e->link, &q->list);
+    q->size++;
+    return true;
+}
+
+/* Remove an element from head of queue */
+bool sq_remove_head(struct list_head *head, char *sp, size_t bufsize)
+{
+    if (!head)
+        return false;
+
+    squeue_t *q = sq_entry(head);
+    struct slist_node *node = stailq_del_head(&q->list);
+    if (!node)
+        return false;
+
+    sq_element_t *e = container_of(node, sq_element_t, link);
+    if (sp && bufsize > 0) {
+        strncpy(sp, e->value, bufsize - 1);
+        sp[bufsize - 1] = '\0';
+    }
+    free(e->value);
+    free(e);
+    q->size--;
+    return true;
+}
+
+/* Return number of elements in queue */
+size_t sq_size(struct list_head *head)
+{
+    return head ? sq_entry(head)->size : 0;
+}
+
+/* Reverse elements in queue by pushing them back at the head */
+void sq_reverse(struct list_head *head)
+{
+    if (!head)
+        return;
+
+    squeue_t *q = sq_entry(head);
+    struct slist_node *node = q->list.first;
+    INIT_STAILQ_HEAD(&q->list);
+    while (node) {
+        struct slist_node *next = node->next;
+        stailq_add(node, &q->list);
+        node = next;
+    }
+}
+
+/* Get the first elements of the queue */
+size_t sq_peek(struct list_head *head, const char **out, size_t n)
+{
+    if (!head)
+        return 0;
+
+    const squeue_t *q = sq_entry(head);
+    const struct slist_node *node;
+    size_t got = 0;
+    stailq_for_each(node, &q->list) {
+        if (got == n)
+            break;
+        out[got++] = container_of(node, sq_element_t, link)->value;
+    }
+    return got;
+}
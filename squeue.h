@@ -0,0 +1,114 @@
+#ifndef LAB0_SQUEUE_H
+#define LAB0_SQUEUE_H
+
+/* This program implements a FIFO queue of strings on a singly-linked tail
+ * queue.
+ *
+ * Every element links to the next one only, saving one pointer per element
+ * compared to element_t. Elements can be inserted at both ends and removed
+ * from the head, the operations a FIFO or a stack needs.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "harness.h"
+#include "list.h"
+
+/**
+ * sq_element_t - Element of a singly-linked queue
+ * @value: pointer to array holding string
+ * @link: link to the next element
+ */
+typedef struct {
+    char *value;
+    struct slist_node link;
+} sq_element_t;
+
+/**
+ * squeue_t - Singly-linked queue
+ * @head: list head used as the handle of the queue, so that it can be kept
+ *        wherever a queue head is expected. It is never linked and always
+ *        looks like an empty list.
+ * @list: the elements, first element first
+ * @size: number of elements
+ */
+typedef struct {
+    struct list_head head;
+    struct stailq_head list;
+    size_t size;
+} squeue_t;
+
+/* Operations on singly-linked queue */
+
+/**
+ * sq_new() - Create an empty singly-linked queue
+ *
+ * Return: the handle of the queue, NULL for allocation failed
+ */
+struct list_head *sq_new();
+
+/**
+ * sq_free() - Free all storage used by the queue, no effect if @head is NULL
+ * @head: handle of the queue
+ */
+void sq_free(struct list_head *head);
+
+/**
+ * sq_insert_head() - Insert an element at the head
+ * @head: handle of the queue
+ * @s: string would be inserted
+ *
+ * Return: true for success, false for allocation failed or @head is NULL
+ */
+bool sq_insert_head(struct list_head *head, const char *s);
+
+/**
+ * sq_insert_tail() - Insert an element at the tail
+ * @head: handle of the queue
+ * @s: string would be inserted
+ *
+ * Return: true for success, false for allocation failed or @head is NULL
+ */
+bool sq_insert_tail(struct list_head *head, const char *s);
+
+/**
+ * sq_remove_head() - Remove and release the element from head of the queue
+ * @head: handle of the queue
+ * @sp: output buffer where the removed string is copied
+ * @bufsize: size of the string
+ *
+ * There is no sq_remove_tail(): the element before the tail cannot be reached
+ * without walking the whole queue.
+ *
+ * Return: true for success, false if queue is NULL or empty.
+ */
+bool sq_remove_head(struct list_head *head, char *sp, size_t bufsize);
+
+/**
+ * sq_size() - Get the number of elements in the queue
+ * @head: handle of the queue
+ *
+ * Return: the number of elements, zero if queue is NULL or empty
+ */
+size_t sq_size(struct list_head *head);
+
+/**
+ * sq_reverse() - Reverse elements in the queue
+ * @head: handle of the queue
+ *
+ * No effect if queue is NULL or empty. Elements are relinked in place.
+ */
+void sq_reverse(struct list_head *head);
+
+/**
+ * sq_peek() - Get the first elements of the queue
+ * @head: handle of the queue
+ * @out: array receiving pointers to the strings, from the head onward
+ * @n: capacity of @out
+ *
+ * Return: the number of strings stored in @out
+ */
+size_t sq_peek(struct list_head *head, const char **out, size_t n);
+
+#endif /* LAB0_SQUEUE_H */
@@ -0,0 +1,38 @@
+#ifndef LAB0_STATS_H
+#define LAB0_STATS_H
+
+/* This program counts the work done by queue operations.
+ *
+ * The counters tell whether an operation got slower by doing more comparisons
+ * or by visiting more nodes, and can be compared against theoretical bounds
+ * such as n * log2(n) comparisons for a sort. They are only maintained when
+ * built with QUEUE_STATS defined ("make STATS=1"), and otherwise every update
+ * compiles to nothing.
+ */
+
+#include <stdint.h>
+
+/**
+ * queue_stats_t - Counters of the work done by queue operations
+ * @compares: string comparisons
+ * @hops: nodes visited, each link followed or rewritten once per node
+ * @merges: merges of sorted lists, a k-way merge counting once
+ */
+typedef struct {
+    uint64_t compares;
+    uint64_t hops;
+    uint64_t merges;
+} queue_stats_t;
+
+/* Counters updated by queue.c, cleared by whoever reads them */
+extern queue_stats_t queue_stats;
+
+#ifdef QUEUE_STATS
+#define STATS_ADD(field, n) ((void) (queue_stats.field += (n)))
+#else
+#define STATS_ADD(field, n) ((void) 0)
+#endif
+
+#define STATS_INC(field) STATS_ADD(field, 1)
+
+#endif /* LAB0_STATS_H */
@@ -0,0 +1,13 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "queue.h"
+#include "tqueue.h"
+
+#define i64_cmp(a, b) ((*(a) > *(b)) - (*(a) < *(b)))
+/* Flipping the sign bit orders signed keys as unsigned ones */
+#define i64_radix(a) ((uint64_t) *(a) ^ (UINT64_C(1) << 63))
+TQUEUE_DEFINE_RADIX(i64q, int64_t, i64_cmp, i64_radix)
+
+#define key16_cmp(a, b) memcmp((a)->bytes, (b)->bytes, sizeof((a)->bytes))
+TQUEUE_DEFINE(k16q, key16_t, key16_cmp)
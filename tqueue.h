@@ -0,0 +1,368 @@
+#ifndef LAB0_TQUEUE_H
+#define LAB0_TQUEUE_H
+
+/* This program generates queues of fixed-size keys.
+ *
+ * queue.c stores strings and compares them with strcmp. The macros below
+ * generate the same operations for any key type that can be copied by
+ * assignment, with a comparison known at compile time, so that sorting,
+ * deduplication and merging are specialized for the key type. Instances for
+ * 64-bit integers and 16-byte keys are provided.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "harness.h"
+#include "list.h"
+
+/**
+ * TQUEUE_DECLARE() - Declare a queue of keys
+ * @name: prefix of the generated type and functions
+ * @type: type of the keys
+ *
+ * Declares the element type name##_element_t, holding a key and a list_head,
+ * and the following functions, which behave like their counterparts in
+ * queue.h with keys in place of strings:
+ *
+ * - struct list_head *name##_new(): create an empty queue, NULL for allocation
+ *   failed
+ * - void name##_free(struct list_head *head): free all storage used by queue
+ * - bool name##_insert_head(struct list_head *head, type key) and
+ *   name##_insert_tail(): insert a key, false for allocation failed or @head
+ *   is NULL
+ * - bool name##_remove_head(struct list_head *head, type *key) and
+ *   name##_remove_tail(): remove and release an element, storing its key into
+ *   @key if not NULL, false if queue is NULL or empty
+ * - int name##_size(struct list_head *head): number of elements
+ * - void name##_reverse(struct list_head *head): reverse elements
+ * - void name##_sort(struct list_head *head, bool descend): stable sort
+ * - bool name##_delete_dup(struct list_head *head): delete all elements of
+ *   the sorted queue whose key appears more than once, false if queue is NULL
+ *   or empty
+ * - int name##_merge(struct list_head *head, bool descend): merge the sorted
+ *   queues of a chain of queue_contex_t into the first one, return its size
+ */
+#define TQUEUE_DECLARE(name, type)                                            \
+    typedef struct {                                                          \
+        type key;                                                             \
+        struct list_head list;                                                \
+    } name##_element_t;                                                       \
+                                                                              \
+    struct list_head *name##_new();                                           \
+    void name##_free(struct list_head *head);                                 \
+    bool name##_insert_head(struct list_head *head, type key);                \
+    bool name##_insert_tail(struct list_head *head, type key);                \
+    bool name##_remove_head(struct list_head *head, type *key);               \
+    bool name##_remove_tail(struct list_head *head, type *key);               \
+    int name##_size(struct list_head *head);                                  \
+    void name##_reverse(struct list_head *head);                              \
+    void name##_sort(struct list_head *head, bool descend);                   \
+    bool name##_delete_dup(struct list_head *head);                           \
+    int name##_merge(struct list_head *head, bool descend);
+
+/**
+ * TQUEUE_DEFINE() - Define the functions declared by TQUEUE_DECLARE()
+ * @name: prefix of the generated type and functions
+ * @type: type of the keys
+ * @cmp: comparison of two keys given by "const type *", a function or a
+ *       function-like macro returning <0, 0 or >0 like strcmp
+ *
+ * Sorting is a merge sort. The expansion needs queue.h for queue_contex_t.
+ */
+#define TQUEUE_DEFINE(name, type, cmp)                                        \
+    __TQUEUE_DEFINE_OPS(name, type, cmp)                                      \
+                                                                              \
+    void name##_sort(struct list_head *head, bool descend)                    \
+    {                                                                         \
+        if (head)                                                             \
+            name##_list_sort(&descend, head);                                 \
+    }
+
+/**
+ * tqueue_radix_item_t - Node of a queue being radix sorted
+ * @key: key of the node, mapped to an unsigned integer of the same order
+ * @node: the node
+ */
+typedef struct {
+    uint64_t key;
+    struct list_head *node;
+} tqueue_radix_item_t;
+
+/**
+ * tqueue_radix_sort() - Stable LSD radix sort of an array of nodes
+ * @items: the items to sort
+ * @tmp: scratch space for as many items
+ * @n: number of items
+ *
+ * The keys are sorted one byte at a time from the least significant one. The
+ * counts of every byte are gathered in a single pass, and a byte shared by
+ * every key is skipped, so small keys take fewer passes.
+ *
+ * Return: @items or @tmp, whichever holds the sorted items
+ */
+static inline tqueue_radix_item_t *tqueue_radix_sort(tqueue_radix_item_t *items,
+                                                     tqueue_radix_item_t *tmp,
+                                                     size_t n)
+{
+    size_t count[8][256] = {{0}};
+    for (size_t i = 0; i < n; i++) {
+        for (int d = 0; d < 8; d++)
+            count[d][(items[i].key >> (8 * d)) & 0xff]++;
+    }
+
+    for (int d = 0; d < 8; d++) {
+        if (count[d][(items[0].key >> (8 * d)) & 0xff] == n)
+            continue;
+
+        size_t offset = 0;
+        for (int b = 0; b < 256; b++) {
+            size_t c = count[d][b];
+            count[d][b] = offset;
+            offset += c;
+        }
+        for (size_t i = 0; i < n; i++)
+            tmp[count[d][(items[i].key >> (8 * d)) & 0xff]++] = items[i];
+
+        tqueue_radix_item_t *sorted = tmp;
+        tmp = items;
+        items = sorted;
+    }
+    return items;
+}
+
+/**
+ * TQUEUE_DEFINE_RADIX() - Define the functions declared by TQUEUE_DECLARE(),
+ * sorting with an LSD radix sort
+ * @name: prefix of the generated type and functions
+ * @type: type of the keys
+ * @cmp: comparison of two keys, as for TQUEUE_DEFINE()
+ * @radix: function-like macro mapping the key given by "const type *" to a
+ *         uint64_t, such that keys compare as their images do
+ *
+ * Walking the nodes of a list costs a cache miss each once they are scattered,
+ * so the sort does not relink nodes once per digit. It gathers the keys and
+ * nodes into an array, sorts that with tqueue_radix_sort() and relinks the
+ * nodes once, in O(n) list walks. It falls back to the merge sort of
+ * TQUEUE_DEFINE() if the array cannot be allocated.
+ */
+#define TQUEUE_DEFINE_RADIX(name, type, cmp, radix)                           \
+    __TQUEUE_DEFINE_OPS(name, type, cmp)                                      \
+                                                                              \
+    void name##_sort(struct list_head *head, bool descend)                    \
+    {                                                                         \
+        if (!head || list_empty(head) || list_is_singular(head))              \
+            return;                                                           \
+                                                                              \
+        size_t n = 0;                                                         \
+        struct list_head *node;                                               \
+        list_for_each(node, head)                                             \
+            n++;                                                              \
+        tqueue_radix_item_t *items = malloc(2 * n * sizeof(*items));          \
+        if (!items) {                                                         \
+            name##_list_sort(&descend, head);                                 \
+            return;                                                           \
+        }                                                                     \
+                                                                              \
+        /* Complemented keys sort descending and keep equal keys in order */  \
+        size_t i = 0;                                                         \
+        list_for_each(node, head) {                                           \
+            uint64_t key =                                                    \
+                radix(&list_entry(node, name##_element_t, list)->key);        \
+            items[i].key = descend ? ~key : key;                              \
+            items[i++].node = node;                                           \
+        }                                                                     \
+                                                                              \
+        tqueue_radix_item_t *sorted = tqueue_radix_sort(items, items + n, n); \
+        INIT_LIST_HEAD(head);                                                 \
+        for (i = 0; i < n; i++) {                                             \
+            if (i + LIST_PREFETCH_DISTANCE < n)                               \
+                list_prefetch(sorted[i + LIST_PREFETCH_DISTANCE].node);       \
+            list_add_tail(sorted[i].node, head);                              \
+        }                                                                     \
+        free(items);                                                          \
+    }
+
+/* Operations shared by every definition of a queue of keys but sorting */
+#define __TQUEUE_DEFINE_OPS(name, type, cmp)                                  \
+    static inline int name##_cmp(void *priv, const struct list_head *a,       \
+                                 const struct list_head *b)                   \
+    {                                                                         \
+        int c = cmp(&list_entry(a, name##_element_t, list)->key,              \
+                    &list_entry(b, name##_element_t, list)->key);             \
+        return *(const bool *) priv ? -c : c;                                 \
+    }                                                                         \
+                                                                              \
+    LIST_SORT_DEFINE(name##_list_sort, name##_cmp)                            \
+                                                                              \
+    struct list_head *name##_new()                                            \
+    {                                                                         \
+        struct list_head *head = malloc(sizeof(struct list_head));            \
+        if (head)                                                             \
+            INIT_LIST_HEAD(head);                                             \
+        return head;                                                          \
+    }                                                                         \
+                                                                              \
+    void name##_free(struct list_head *head)                                  \
+    {                                                                         \
+        if (!head)                                                            \
+            return;                                                           \
+        name##_element_t *entry, *safe;                                       \
+        list_for_each_entry_safe(entry, safe, head, list)                     \
+            free(entry);                                                      \
+        free(head);                                                           \
+    }                                                                         \
+                                                                              \
+    bool name##_insert_head(struct list_head *head, type key)                 \
+    {                                                                         \
+        if (!head)                                                            \
+            return false;                                                     \
+        name##_element_t *entry = malloc(sizeof(name##_element_t));           \
+        if (!entry)                                                           \
+            return false;                                                     \
+        entry->key = key;                                                     \
+        list_add(&entry->list, head);                                         \
+        return true;                                                          \
+    }                                                                         \
+                                                                              \
+    bool name##_insert_tail(struct list_head *head, type key)                 \
+    {                                                                         \
+        if (!head)                                                            \
+            return false;                                                     \
+        name##_element_t *entry = malloc(sizeof(name##_element_t));           \
+        if (!entry)                                                           \
+            return false;                                                     \
+        entry->key = key;                                                     \
+        list_add_tail(&entry->list, head);                                    \
+        return true;                                                          \
+    }                                                                         \
+                                                                              \
+    static bool name##_remove(struct list_head *node, type *key)              \
+    {                                                                         \
+        name##_element_t *entry = list_entry(node, name##_element_t, list);   \
+        if (key)                                                              \
+            *key = entry->key;                                                \
+        list_del(node);                                                       \
+        free(entry);                                                          \
+        return true;                                                          \
+    }                                                                         \
+                                                                              \
+    bool name##_remove_head(struct list_head *head, type *key)                \
+    {                                                                         \
+        return head && !list_empty(head) && name##_remove(head->next, key);   \
+    }                                                                         \
+                                                                              \
+    bool name##_remove_tail(struct list_head *head, type *key)                \
+    {                                                                         \
+        return head && !list_empty(head) && name##_remove(head->prev, key);   \
+    }                                                                         \
+                                                                              \
+    int name##_size(struct list_head *head)                                   \
+    {                                                                         \
+        int count = 0;                                                        \
+        struct list_head *node;                                               \
+        if (head)                                                             \
+            list_for_each(node, head)                                         \
+                count++;                                                      \
+        return count;                                                         \
+    }                                                                         \
+                                                                              \
+    void name##_reverse(struct list_head *head)                               \
+    {                                                                         \
+        struct list_head *node, *safe;                                        \
+        if (head)                                                             \
+            list_for_each_safe(node, safe, head)                              \
+                list_move(node, head);                                        \
+    }                                                                         \
+                                                                              \
+    bool name##_delete_dup(struct list_head *head)                            \
+    {                                                                         \
+        if (!head || list_empty(head))                                        \
+            return false;                                                     \
+        name##_element_t *entry, *safe;                                       \
+        bool duplicate = false;                                               \
+        list_for_each_entry_safe(entry, safe, head, list) {                   \
+            bool next_equal = &safe->list != head &&                          \
+                              cmp(&entry->key, &safe->key) == 0;              \
+            if (next_equal || duplicate) {                                    \
+                list_del(&entry->list);                                       \
+                free(entry);                                                  \
+            }                                                                 \
+            duplicate = next_equal;                                           \
+        }                                                                     \
+        return true;                                                          \
+    }                                                                         \
+                                                                              \
+    int name##_merge(struct list_head *head, bool descend)                    \
+    {                                                                         \
+        if (!head || list_empty(head))                                        \
+            return 0;                                                         \
+                                                                              \
+        /* Splice the queues one after another and merge the runs pairwise,   \
+         * the first run being the first queue.                               \
+         */                                                                   \
+        queue_contex_t *first =                                               \
+            list_first_entry(head, queue_contex_t, chain);                    \
+        queue_contex_t *entry;                                                \
+        struct list_head *runs = NULL, **tail = &runs;                        \
+        int k = 0;                                                            \
+        list_for_each_entry(entry, head, chain) {                             \
+            if (list_empty(entry->q))                                         \
+                continue;                                                     \
+            entry->q->prev->next = NULL;                                      \
+            *tail = entry->q->next;                                           \
+            tail = &entry->q->next->prev;                                     \
+            INIT_LIST_HEAD(entry->q);                                         \
+            entry->size = 0;                                                  \
+            k++;                                                              \
+        }                                                                     \
+        *tail = NULL;                                                         \
+                                                                              \
+        /* Each round merges neighbouring runs, chained through the prev      \
+         * pointer of their first node.                                       \
+         */                                                                   \
+        while (k > 1) {                                                       \
+            struct list_head *merged = NULL, **out = &merged;                 \
+            while (runs) {                                                    \
+                struct list_head *a = runs, *b = a->prev;                     \
+                if (b) {                                                      \
+                    runs = b->prev;                                           \
+                    a = name##_list_sort_merge(&descend, a, b);               \
+                    k--;                                                      \
+                } else {                                                      \
+                    runs = NULL;                                              \
+                }                                                             \
+                *out = a;                                                     \
+                out = &a->prev;                                               \
+            }                                                                 \
+            *out = NULL;                                                      \
+            runs = merged;                                                    \
+        }                                                                     \
+                                                                              \
+        int count = 0;                                                        \
+        struct list_head *prev = first->q;                                    \
+        for (struct list_head *node = runs; node; node = node->next) {        \
+            node->prev = prev;                                                \
+            prev->next = node;                                                \
+            prev = node;                                                      \
+            count++;                                                          \
+        }                                                                     \
+        prev->next = first->q;                                                \
+        first->q->prev = prev;                                                \
+        first->size = count;                                                  \
+        return count;                                                         \
+    }
+
+/**
+ * key16_t - Fixed-width key of 16 bytes, ordered by memcmp()
+ * @bytes: the key, such as a string padded with NUL bytes
+ */
+typedef struct {
+    unsigned char bytes[16];
+} key16_t;
+
+TQUEUE_DECLARE(i64q, int64_t)
+TQUEUE_DECLARE(k16q, key16_t)
+
+#endif /* LAB0_TQUEUE_H */
@@ -0,0 +1,60 @@
+# Test of a steady FIFO workload on a persistent queue, with snapshots
+option persistent 1
+new
+it a
+it b
+it c
+it d
+rh a
+it e
+rh b
+it f
+rh c
+it g
+rh d
+it h
+rh e
+it i
+rh f
+it j
+rh g
+it k
+rh h
+it l
+rh i
+it m
+rh j
+it n
+rh k
+it o
+rh l
+it p
+rh m
+it q
+rh n
+it r
+rh o
+it s
+rh p
+it t
+snapshot
+rh q
+it u
+rh r
+it v
+rh s
+it w
+rh t
+it x
+rh u
+it y
+rh v
+it z
+restore
+rh q
+rt t
+it z
+rh r
+rh s
+rh z
+free
@@ -0,0 +1,25 @@
+# Test of converting the queue between the list and arena backends
+new
+ih b
+ih a
+it c
+it d
+option backend arena
+it e
+rh a
+reverse
+option backend list
+rh e
+rt b
+it f
+sort
+option backend arena
+rh c
+rh d
+rh f
+size
+new
+option backend list
+free
+free
+option backend list
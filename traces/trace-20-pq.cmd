@@ -0,0 +1,21 @@
+# Test of 'pq_push' and 'pq_pop' in both orders
+pq_push dog
+pq_push cat
+pq_push eel 2
+pq_push ant
+pq_pop ant
+pq_pop cat
+pq_push bee
+pq_pop bee
+pq_pop dog
+pq_pop eel
+pq_pop eel
+pq_pop
+option descend 1
+pq_push RAND 20
+pq_push zzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzz
+pq_pop zzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzz
+option descend 0
+pq_push a
+pq_pop a
+free
@@ -0,0 +1,36 @@
+# Test of 'sort -u' and 'merge -u', deleting duplicate strings while sorting
+new
+it d
+ih a 3
+it c
+ih b
+it d
+sort -u
+rh b
+rh c
+ih RAND 50
+it x 4
+sort -u
+free
+new
+ih e
+ih d 2
+ih a
+sort
+new
+it d
+it f
+it b
+sort
+new
+it g
+it c
+sort
+merge -u
+rh a
+rh b
+rh c
+rh e
+rh f
+rh g
+free
@@ -0,0 +1,26 @@
+# Test of 'nth' and 'partition' against sorting
+new
+ih RAND 100
+nth 0
+nth 50 -s
+nth 99
+it m
+partition m
+free
+free
+new
+it c
+it a
+it d
+it b
+it c
+partition c -s
+rh a
+rh b
+new
+it e
+it d
+nth 1
+free
+free
+free
@@ -0,0 +1,29 @@
+# Test of 'scatter' and 'gather' over the queue chain
+new
+new
+new
+prev
+prev
+it a
+it b
+it c
+it d
+it e
+it f
+it g
+scatter rr
+gather
+scatter hash
+gather
+scatter range
+gather
+sort
+rh a
+rh b
+rh c
+ih RAND 30
+scatter
+gather
+free
+free
+free
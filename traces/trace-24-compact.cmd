@@ -0,0 +1,49 @@
+# Test of 'compact' keeping the order of the queue
+new
+ih RAND 40
+sort
+compact
+sort
+reverse
+compact
+free
+new
+it a
+it b
+ih c
+compact
+rh c
+rh a
+rh b
+compact
+free
+new
+ih RAND 30
+it RAND 30
+dm
+rh
+dm
+rt
+dm
+sort
+compact
+dm
+rh
+compact
+free
+option intern 1
+new
+ih gerbil 4
+it dolphin 3
+compact
+rh gerbil
+compact
+free
+option intern 0
+new
+ih RAND 20
+option malloc 50
+compact
+compact
+option malloc 0
+free
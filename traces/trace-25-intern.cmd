@@ -0,0 +1,17 @@
+# Test of string interning with repeated and distinct strings
+option intern 1
+new
+ih dolphin 5
+it dolphin 3
+ih RAND 10
+it gerbil 2
+rt gerbil
+dedup
+sort
+dedup
+new
+ih dolphin 2
+rh dolphin
+free
+free
+option intern 0
@@ -0,0 +1,25 @@
+# Test of run-length encoded queues with long runs of equal strings
+option rle 1
+new
+ih b 1000
+ih a 500
+it c 2000
+it b
+rh a
+rt b
+size
+reverse
+rh c
+sort
+rh a
+it d
+dedup
+rh d
+rh
+new
+ih RAND 20
+it x 100
+sort
+free
+free
+option rle 0
@@ -0,0 +1,14 @@
+# Test of releasing deleted elements in the background reclaimer thread
+option reclaim 1
+new
+ih RAND 1000
+it dup 100
+sort
+dedup
+rh
+rt
+new
+ih gerbil 5000
+free
+free
+option reclaim 0
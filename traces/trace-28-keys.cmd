@@ -0,0 +1,30 @@
+# Test of queues of integer and 16-byte keys, sorted by radix sort
+option keys 1
+new
+ih 42
+it -7
+it 42
+ih 3 2
+it 9223372036854775807
+it -9223372036854775808
+sort
+rh -9223372036854775808
+rh -7
+rt 9223372036854775807
+it 5
+option descend 1
+sort
+option descend 0
+dedup
+rh 5
+ih RAND 1000
+sort
+free
+option keys 2
+new
+ih RAND 200
+it key
+sort
+reverse
+free
+option keys 0
@@ -0,0 +1,35 @@
+# Test of the queue backends and of 'replay' running a trace against them
+replay traces/trace-01-ops.cmd
+replay traces/trace-01-ops.cmd arena xor
+option backend slist
+new
+ih b
+it c
+ih a
+rh a
+rh b
+rh c
+free
+option backend xor
+new
+it b
+it a
+ih c
+reverse
+rh a
+rt c
+free
+option backend array
+new
+ih RAND 100
+it z
+rt z
+sort
+free
+option backend chunk
+new
+ih x 300
+it y 300
+dedup
+free
+option backend list
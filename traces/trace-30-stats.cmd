@@ -0,0 +1,16 @@
+# Test of 'stats' reading and clearing the work counters
+stats
+new
+ih RAND 1000
+sort
+stats
+stats
+new
+it a
+it c
+new
+it b
+it d
+merge
+stats
+free
@@ -0,0 +1,21 @@
+# Test of sorting queues larger than sortmem in runs merged back together
+option sortmem 1
+new
+ih RAND 5000
+it zzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzz
+ih a 100
+sort
+rh a
+rt zzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzz
+option descend 1
+sort
+option descend 0
+reverse
+sort
+option malloc 10
+sort
+option malloc 0
+sort
+size
+free
+option sortmem 0
@@ -0,0 +1,30 @@
+# Test of queues stored in a file with 'open' and 'sync'
+new
+dump /tmp/qtest.fq
+free
+option backend mmap
+open /tmp/qtest.fq
+it a
+it b
+ih c
+sync
+rh c
+it d
+free
+open /tmp/qtest.fq
+rh c
+rh a
+reverse
+it e 3
+ih RAND 20
+sync
+free
+open /tmp/qtest.fq
+size
+reverse
+rh e
+rh e
+rh e
+rh b
+free
+option backend list
@@ -0,0 +1,28 @@
+# Test of saving all queues with 'save' and restoring them with 'load'
+new
+it a
+it b
+new
+ih RAND 30
+it c
+new
+prev
+save /tmp/qtest.session
+free
+free
+free
+load /tmp/qtest.session
+rt c
+prev
+rh a
+rh b
+next
+next
+size
+free
+free
+free
+load /tmp/qtest.session
+free
+free
+free
@@ -0,0 +1,21 @@
+# Test of 'loadfile' inserting every line of a file at the tail
+new
+it gerbil
+it bear
+ih dolphin
+dump /tmp/qtest.lines
+free
+new
+it lion
+loadfile /tmp/qtest.lines
+loadfile /tmp/qtest.lines
+rh lion
+rh dolphin
+rh gerbil
+rh bear
+rt bear
+rt gerbil
+rt dolphin
+loadfile traces/trace-01-ops.cmd
+size
+free
@@ -0,0 +1,16 @@
+# Test of 'dump' writing every string of the queue to a file
+new
+dump /tmp/qtest.lines
+loadfile /tmp/qtest.lines
+ih RAND 1000
+it wwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwwww 100
+dump /tmp/qtest.lines
+new
+loadfile /tmp/qtest.lines
+loadfile /tmp/qtest.lines
+it zebra
+sort -u
+rh zebra
+size
+free
+free
@@ -0,0 +1,89 @@
+#ifndef LAB0_VARINT_H
+#define LAB0_VARINT_H
+
+/* This program encodes unsigned integers in a variable number of bytes.
+ *
+ * A number is written as 7-bit groups, least significant first, the high bit
+ * of each byte telling whether more follow, so small numbers such as string
+ * lengths take a single byte. Session files use this encoding.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/* Bytes taken by the largest 64-bit number */
+#define VARINT_MAX_BYTES 10
+
+/**
+ * varint_put() - Write a number to a file
+ * @file: stream to write to
+ * @v: number to write
+ *
+ * Return: true if every byte was written
+ */
+static inline bool varint_put(FILE *file, uint64_t v)
+{
+    do {
+        int byte = v & 0x7f;
+        v >>= 7;
+        if (putc(v ? byte | 0x80 : byte, file) == EOF)
+            return false;
+    } while (v);
+    return true;
+}
+
+/**
+ * varint_read() - Decode a number from a source of bytes
+ * @v: where the number is stored
+ * @next: get the next byte from @priv, returning false when there is none
+ * @priv: source of bytes passed to @next
+ *
+ * Return: true if a complete number was read
+ */
+static inline bool varint_read(uint64_t *v,
+                               bool (*next)(void *priv, unsigned char *byte),
+                               void *priv)
+{
+    *v = 0;
+    for (unsigned i = 0; i < VARINT_MAX_BYTES; i++) {
+        unsigned char byte;
+        if (!next(priv, &byte))
+            return false;
+        *v |= (uint64_t) (byte & 0x7f) << (7 * i);
+        if (!(byte & 0x80))
+            return true;
+    }
+    return false;
+}
+
+typedef struct {
+    const unsigned char **p, *end;
+} varint_buf_t;
+
+static inline bool varint_buf_next(void *priv, unsigned char *byte)
+{
+    varint_buf_t *buf = priv;
+    if (*buf->p == buf->end)
+        return false;
+    *byte = *(*buf->p)++;
+    return true;
+}
+
+/**
+ * varint_get() - Decode a number from a buffer
+ * @p: start of the number, advanced past it
+ * @end: end of the buffer
+ * @v: where the number is stored
+ *
+ * Return: true if a complete number was read before @end
+ */
+static inline bool varint_get(const unsigned char **p,
+                              const unsigned char *end,
+                              uint64_t *v)
+{
+    varint_buf_t buf = {p, end};
+    return varint_read(v, varint_buf_next, &buf);
+}
+
+#endif /* LAB0_VARINT_H */
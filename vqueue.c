@@ -0,0 +1,230 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "vqueue.h"
+
+#define vq_entry(h) container_of(h, vqueue_t, head)
+
+/* Number of slots of a new queue */
+#define VQ_INIT_CAPACITY 16
+
+/* Address of the slot holding element @i */
+static inline char **vq_slot(const vqueue_t *q, size_t i)
+{
+    return &q->slots[(q->first + i) & (q->capacity - 1)];
+}
+
+/* Create an empty queue */
+struct list_head *vq_new()
+{
+    vqueue_t *q = malloc(sizeof(vqueue_t));
+    if (!q)
+        return NULL;
+
+    q->slots = malloc(VQ_INIT_CAPACITY * sizeof(char *));
+    if (!q->slots) {
+        free(q);
+        return NULL;
+    }
+    q->capacity = VQ_INIT_CAPACITY;
+    q->first = q->size = 0;
+
+    INIT_LIST_HEAD(&q->head);
+    return &q->head;
+}
+
+/* Free all storage used by queue */
+void vq_free(struct list_head *head)
+{
+    if (!head)
+        return;
+
+    vqueue_t *q = vq_entry(head);
+    for (size_t i = 0; i < q->size; i++)
+        free(*vq_slot(q, i));
+    free(q->slots);
+    free(q);
+}
+
+/* Double the ring buffer, moving the elements to its beginning */
+static bool vq_grow(vqueue_t *q)
+{
+    char **slots = malloc(2 * q->capacity * sizeof(char *));
+    if (!slots)
+        return false;
+
+    for (size_t i = 0; i < q->size; i++)
+        slots[i] = *vq_slot(q, i);
+    free(q->slots);
+    q->slots = slots;
+    q->capacity *= 2;
+    q->first = 0;
+    return true;
+}
+
+/* Insert an element at head of queue */
+bool vq_insert_head(struct list_head *head, const char *s)
+{
+    if (!head || !s)
+        return false;
+
+    vqueue_t *q = vq_entry(head);
+    if (q->size == q->capacity && !vq_grow(q))
+        return false;
+
+    char *value = strdup(s);
+    if (!value)
+        return false;
+    q->first = (q->first - 1) & (q->capacity - 1);
+    q->slots[q->first] = value;
+    q->size++;
+    return true;
+}
+
+/* Insert an element at tail of queue */
+bool vq_insert_tail(struct list_head *head, const char *s)
+{
+    if (!head || !s)
+        return false;
+
+    vqueue_t *q = vq_entry(head);
+    if (q->size == q->capacity && !vq_grow(q))
+        return false;
+
+    char *value = strdup(s);
+    if (!value)
+        return false;
+    *vq_slot(q, q->size++) = value;
+    return true;
+}
+
+/* Copy a removed string to @sp and release it */
+static void vq_release(char *value, char *sp, size_t bufsize)
+{
+    if (sp && bufsize > 0) {
+        strncpy(sp, value, bufsize - 1);
+        sp[bufsize - 1] = '\0';
+    }
+    free(value);
+}
+
+/* Remove an element from head of queue */
+bool vq_remove_head(struct list_head *head, char *sp, size_t bufsize)
+{
+    if (!head || !vq_entry(head)->size)
+        return false;
+
+    vqueue_t *q = vq_entry(head);
+    vq_release(q->slots[q->first], sp, bufsize);
+    q->first = (q->first + 1) & (q->capacity - 1);
+    q->size--;
+    return true;
+}
+
+/* Remove an element from tail of queue */
+bool vq_remove_tail(struct list_head *head, char *sp, size_t bufsize)
+{
+    if (!head || !vq_entry(head)->size)
+        return false;
+
+    vqueue_t *q = vq_entry(head);
+    vq_release(*vq_slot(q, --q->size), sp, bufsize);
+    return true;
+}
+
+/* Return number of elements in queue */
+size_t vq_size(struct list_head *head)
+{
+    return head ? vq_entry(head)->size : 0;
+}
+
+/* Reverse elements in queue by swapping them pairwise */
+void vq_reverse(struct list_head *head)
+{
+    if (!head)
+        return;
+
+    vqueue_t *q = vq_entry(head);
+    for (size_t i = 0, j = q->size; i + 1 < j; i++, j--) {
+        char **a = vq_slot(q, i), **b = vq_slot(q, j - 1);
+        char *tmp = *a;
+        *a = *b;
+        *b = tmp;
+    }
+}
+
+/* Reverse the slots from @lo to @hi, excluded */
+static void vq_flip(char **slots, size_t lo, size_t hi)
+{
+    while (lo + 1 < hi) {
+        char *tmp = slots[lo];
+        slots[lo++] = slots[--hi];
+        slots[hi] = tmp;
+    }
+}
+
+static int cmp_ascend(const void *a, const void *b)
+{
+    return strcmp(*(char *const *) a, *(char *const *) b);
+}
+
+static int cmp_descend(const void *a, const void *b)
+{
+    return strcmp(*(char *const *) b, *(char *const *) a);
+}
+
+/* Sort elements of queue in ascending/descending order */
+bool vq_sort(struct list_head *head, bool descend)
+{
+    if (!head)
+        return true;
+
+    vqueue_t *q = vq_entry(head);
+    if (q->first + q->size > q->capacity) {
+        /* Rotate the wrapped elements to the beginning of the buffer */
+        vq_flip(q->slots, 0, q->first);
+        vq_flip(q->slots, q->first, q->capacity);
+        vq_flip(q->slots, 0, q->capacity);
+        q->first = 0;
+    }
+    qsort(q->slots + q->first, q->size, sizeof(char *),
+          descend ? cmp_descend : cmp_ascend);
+    return true;
+}
+
+/* Delete all strings which appear more than once */
+bool vq_delete_dup(struct list_head *head)
+{
+    if (!head || !vq_entry(head)->size)
+        return false;
+
+    vqueue_t *q = vq_entry(head);
+    size_t kept = 0;
+    bool duplicate = false;
+    for (size_t i = 0; i < q->size; i++) {
+        char *value = *vq_slot(q, i);
+        bool next_equal =
+            i + 1 < q->size && !strcmp(value, *vq_slot(q, i + 1));
+        if (next_equal || duplicate)
+            free(value);
+        else
+            *vq_slot(q, kept++) = value;
+        duplicate = next_equal;
+    }
+    q->size = kept;
+    return true;
+}
+
+/* Get the first elements of the queue */
+size_t vq_peek(struct list_head *head, const char **out, size_t n)
+{
+    if (!head)
+        return 0;
+
+    const vqueue_t *q = vq_entry(head);
+    size_t got = n < q->size ? n : q->size;
+    for (size_t i = 0; i < got; i++)
+        out[i] = *vq_slot(q, i);
+    return got;
+}
@@ -0,0 +1,129 @@
+#ifndef LAB0_VQUEUE_H
+#define LAB0_VQUEUE_H
+
+/* This program implements a queue of strings in an array.
+ *
+ * The strings are kept in a ring buffer of pointers, which doubles when full,
+ * so there are no links at all and neighbours are adjacent in memory.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "harness.h"
+#include "list.h"
+
+/**
+ * vqueue_t - Array-backed queue
+ * @head: list head used as the handle of the queue, so that it can be kept
+ *        wherever a queue head is expected. It is never linked and always
+ *        looks like an empty list.
+ * @slots: the ring buffer of strings
+ * @capacity: number of slots, a power of 2
+ * @first: index of the slot holding the first element
+ * @size: number of elements
+ */
+typedef struct {
+    struct list_head head;
+    char **slots;
+    size_t capacity, first, size;
+} vqueue_t;
+
+/* Operations on array-backed queue */
+
+/**
+ * vq_new() - Create an empty array-backed queue
+ *
+ * Return: the handle of the queue, NULL for allocation failed
+ */
+struct list_head *vq_new();
+
+/**
+ * vq_free() - Free all storage used by the queue, no effect if @head is NULL
+ * @head: handle of the queue
+ */
+void vq_free(struct list_head *head);
+
+/**
+ * vq_insert_head() - Insert an element at the head
+ * @head: handle of the queue
+ * @s: string would be inserted
+ *
+ * Return: true for success, false for allocation failed or @head is NULL
+ */
+bool vq_insert_head(struct list_head *head, const char *s);
+
+/**
+ * vq_insert_tail() - Insert an element at the tail
+ * @head: handle of the queue
+ * @s: string would be inserted
+ *
+ * Return: true for success, false for allocation failed or @head is NULL
+ */
+bool vq_insert_tail(struct list_head *head, const char *s);
+
+/**
+ * vq_remove_head() - Remove and release the element from head of the queue
+ * @head: handle of the queue
+ * @sp: output buffer where the removed string is copied
+ * @bufsize: size of the string
+ *
+ * Return: true for success, false if queue is NULL or empty.
+ */
+bool vq_remove_head(struct list_head *head, char *sp, size_t bufsize);
+
+/**
+ * vq_remove_tail() - Remove and release the element from tail of the queue
+ * @head: handle of the queue
+ * @sp: output buffer where the removed string is copied
+ * @bufsize: size of the string
+ *
+ * Return: true for success, false if queue is NULL or empty.
+ */
+bool vq_remove_tail(struct list_head *head, char *sp, size_t bufsize);
+
+/**
+ * vq_size() - Get the number of elements in the queue
+ * @head: handle of the queue
+ *
+ * Return: the number of elements, zero if queue is NULL or empty
+ */
+size_t vq_size(struct list_head *head);
+
+/**
+ * vq_reverse() - Reverse elements in the queue
+ * @head: handle of the queue
+ */
+void vq_reverse(struct list_head *head);
+
+/**
+ * vq_sort() - Sort elements of the queue in ascending/descending order
+ * @head: handle of the queue
+ * @descend: whether or not to sort in descending order
+ *
+ * The strings are sorted in place with qsort(), which is not stable.
+ *
+ * Return: true, sorting never allocates
+ */
+bool vq_sort(struct list_head *head, bool descend);
+
+/**
+ * vq_delete_dup() - Delete all strings of the sorted queue which appear more
+ * than once
+ * @head: handle of the queue
+ *
+ * Return: true for success, false if queue is NULL or empty.
+ */
+bool vq_delete_dup(struct list_head *head);
+
+/**
+ * vq_peek() - Get the first elements of the queue
+ * @head: handle of the queue
+ * @out: array receiving pointers to the strings, from the head onward
+ * @n: capacity of @out
+ *
+ * Return: the number of strings stored in @out
+ */
+size_t vq_peek(struct list_head *head, const char **out, size_t n);
+
+#endif /* LAB0_VQUEUE_H */
@@ -0,0 +1,155 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "xqueue.h"
+
+#define xq_entry(h) container_of(h, xqueue_t, head)
+
+/* Create an empty queue */
+struct list_head *xq_new()
+{
+    xqueue_t *q = malloc(sizeof(xqueue_t));
+    if (!q)
+        return NULL;
+
+    INIT_LIST_HEAD(&q->head);
+    INIT_XLIST_HEAD(&q->list);
+    q->size = 0;
+    return &q->head;
+}
+
+/* Free all storage used by queue */
+void xq_free(struct list_head *head)
+{
+    if (!head)
+        return;
+
+    xqueue_t *q = xq_entry(head);
+    struct xlist_node *node;
+    while ((node = xlist_del_head(&q->list))) {
+        xq_element_t *e = container_of(node, xq_element_t, link);
+        free(e->value);
+        free(e);
+    }
+    free(q);
+}
+
+/* Allocate an element holding a copy of @s */
+static xq_element_t *xq_element_new(const char *s)
+{
+    xq_element_t *e = malloc(sizeof(xq_element_t));
+    if (!e)
+        return NULL;
+
+    e->value = strdup(s);
+    if (!e->value) {
+        free(e);
+        return NULL;
+    }
+    return e;
+}
+
+/* Insert an element at head of queue */
+bool xq_insert_head(struct list_head *head, const char *s)
+{
+    if (!head || !s)
+        return false;
+
+    xqueue_t *q = xq_entry(head);
+    xq_element_t *e = xq_element_new(s);
+    if (!e)
+        return false;
+    xlist_add(&e->link, &q->list);
+    q->size++;
+    return true;
+}
+
+/* Insert an element at tail of queue */
+bool xq_insert_tail(struct list_head *head, const char *s)
+{
+    if (!head || !s)
+        return false;
+
+    xqueue_t *q = xq_entry(head);
+    xq_element_t *e = xq_element_new(s);
+    if (!e)
+        return false;
+    xlist_add_tail(&e->link, &q->list);
+    q->size++;
+    return true;
+}
+
+/* Copy the string of a removed element to @sp and release the element */
+static void xq_release(xqueue_t *q,
+                       struct xlist_node *node,
+                       char *sp,
+                       size_t bufsize)
+{
+    xq_element_t *e = container_of(node, xq_element_t, link);
+    if (sp && bufsize > 0) {
+        strncpy(sp, e->value, bufsize - 1);
+        sp[bufsize - 1] = '\0';
+    }
+    free(e->value);
+    free(e);
+    q->size--;
+}
+
+/* Remove an element from head of queue */
+bool xq_remove_head(struct list_head *head, char *sp, size_t bufsize)
+{
+    if (!head)
+        return false;
+
+    xqueue_t *q = xq_entry(head);
+    struct xlist_node *node = xlist_del_head(&q->list);
+    if (!node)
+        return false;
+    xq_release(q, node, sp, bufsize);
+    return true;
+}
+
+/* Remove an element from tail of queue */
+bool xq_remove_tail(struct list_head *head, char *sp, size_t bufsize)
+{
+    if (!head)
+        return false;
+
+    xqueue_t *q = xq_entry(head);
+    struct xlist_node *node = xlist_del_tail(&q->list);
+    if (!node)
+        return false;
+    xq_release(q, node, sp, bufsize);
+    return true;
+}
+
+/* Return number of elements in queue */
+size_t xq_size(struct list_head *head)
+{
+    return head ? xq_entry(head)->size : 0;
+}
+
+/* Reverse elements in queue */
+void xq_reverse(struct list_head *head)
+{
+    if (head)
+        xlist_reverse(&xq_entry(head)->list);
+}
+
+/* Get the first elements of the queue */
+size_t xq_peek(struct list_head *head, const char **out, size_t n)
+{
+    if (!head)
+        return 0;
+
+    xqueue_t *q = xq_entry(head);
+    struct xlist_node *node, *prev;
+    size_t got = 0;
+    xlist_for_each(node, prev, &q->list) {
+        if (got == n)
+            break;
+        out[got++] = container_of(node, xq_element_t, link)->value;
+    }
+    return got;
+}
@@ -0,0 +1,119 @@
+#ifndef LAB0_XQUEUE_H
+#define LAB0_XQUEUE_H
+
+/* This program implements a double-ended queue of strings on an XOR-linked
+ * list.
+ *
+ * Every element stores the addresses of both neighbours XORed together in a
+ * single word, so it is as small as a singly-linked element, yet elements can
+ * be inserted and removed at both ends and the queue is reversed in O(1).
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "harness.h"
+#include "list.h"
+
+/**
+ * xq_element_t - Element of an XOR-linked queue
+ * @value: pointer to array holding string
+ * @link: link to both neighbours
+ */
+typedef struct {
+    char *value;
+    struct xlist_node link;
+} xq_element_t;
+
+/**
+ * xqueue_t - XOR-linked queue
+ * @head: list head used as the handle of the queue, so that it can be kept
+ *        wherever a queue head is expected. It is never linked and always
+ *        looks like an empty list.
+ * @list: the elements
+ * @size: number of elements
+ */
+typedef struct {
+    struct list_head head;
+    struct xlist_head list;
+    size_t size;
+} xqueue_t;
+
+/* Operations on XOR-linked queue */
+
+/**
+ * xq_new() - Create an empty XOR-linked queue
+ *
+ * Return: the handle of the queue, NULL for allocation failed
+ */
+struct list_head *xq_new();
+
+/**
+ * xq_free() - Free all storage used by the queue, no effect if @head is NULL
+ * @head: handle of the queue
+ */
+void xq_free(struct list_head *head);
+
+/**
+ * xq_insert_head() - Insert an element at the head
+ * @head: handle of the queue
+ * @s: string would be inserted
+ *
+ * Return: true for success, false for allocation failed or @head is NULL
+ */
+bool xq_insert_head(struct list_head *head, const char *s);
+
+/**
+ * xq_insert_tail() - Insert an element at the tail
+ * @head: handle of the queue
+ * @s: string would be inserted
+ *
+ * Return: true for success, false for allocation failed or @head is NULL
+ */
+bool xq_insert_tail(struct list_head *head, const char *s);
+
+/**
+ * xq_remove_head() - Remove and release the element from head of the queue
+ * @head: handle of the queue
+ * @sp: output buffer where the removed string is copied
+ * @bufsize: size of the string
+ *
+ * Return: true for success, false if queue is NULL or empty.
+ */
+bool xq_remove_head(struct list_head *head, char *sp, size_t bufsize);
+
+/**
+ * xq_remove_tail() - Remove and release the element from tail of the queue
+ * @head: handle of the queue
+ * @sp: output buffer where the removed string is copied
+ * @bufsize: size of the string
+ *
+ * Return: true for success, false if queue is NULL or empty.
+ */
+bool xq_remove_tail(struct list_head *head, char *sp, size_t bufsize);
+
+/**
+ * xq_size() - Get the number of elements in the queue
+ * @head: handle of the queue
+ *
+ * Return: the number of elements, zero if queue is NULL or empty
+ */
+size_t xq_size(struct list_head *head);
+
+/**
+ * xq_reverse() - Reverse elements in the queue in O(1)
+ * @head: handle of the queue
+ */
+void xq_reverse(struct list_head *head);
+
+/**
+ * xq_peek() - Get the first elements of the queue
+ * @head: handle of the queue
+ * @out: array receiving pointers to the strings, from the head onward
+ * @n: capacity of @out
+ *
+ * Return: the number of strings stored in @out
+ */
+size_t xq_peek(struct list_head *head, const char **out, size_t n);
+
+#endif /* LAB0_XQUEUE_H */